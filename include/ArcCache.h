@@ -7,11 +7,13 @@
 #include <unordered_map>
 #include <thread>
 #include <mutex>
+#include <utility>
 
 #include "CachePolicy.h"
 #include "ArcNode.h"
 #include "ArcLruPart.h"
 #include "ArcLfuPart.h"
+#include "ShardedCache.h"
 
 namespace mycache {
 
@@ -53,34 +55,102 @@ private:
         return inGhost;
     }
 
-public:
-    explicit ArcCache(size_t Capacity = 10, size_t TransformThreshold = 3)
-    : capacity(Capacity)
-    , transformThreshold(TransformThreshold)
-    , lruPart(std::make_unique<ArcLruPart<K, V>>(Capacity/2, TransformThreshold))
-    , lfuPart(std::make_unique<ArcLfuPart<K, V>>(Capacity/2, TransformThreshold))
-    {}
+    //检查节点是否在幽灵缓存中，调用者已同时持有两个部分的锁
+    bool checkGhostCacheLocked(const K& key)
+    {
+        if(lruPart->checkGhostLocked(key))
+        {
+            if(lfuPart->decreaseCapacityLocked())
+            {
+                lruPart->increaseCapacityLocked();
+            }
+            return true;
+        }
+        if(lfuPart->checkGhostLocked(key))
+        {
+            if(lruPart->decreaseCapacityLocked())
+            {
+                lfuPart->increaseCapacityLocked();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    //读-改-写缓存，同时锁住两个部分，整个过程不会与其他操作交错
+    //与put一样先检查幽灵缓存；旧值按get的顺序先查LRU部分再查LFU部分，fn以旧值的指针（不存在时为nullptr）计算新值
+    //onlyIfPresent为true且旧值不存在时不调用fn、不写入并返回false；否则新值按put的方式写入两个部分并存入result
+    template <typename F>
+    bool computeInternal(const K& key, F&& fn, bool onlyIfPresent, V& result)
+    {
+        std::scoped_lock lock(lruPart->mutex(), lfuPart->mutex());
+
+        bool inGhost = checkGhostCacheLocked(key);
+        const V* old = lruPart->findLocked(key);
+        if(old == nullptr)old = lfuPart->findLocked(key);
+        if(old == nullptr && onlyIfPresent)return false;
+
+        result = fn(old);
+        if(!inGhost)
+        {
+            if(lruPart->putLocked(key, static_cast<const V&>(result)))
+            {
+                lfuPart->putLocked(key, static_cast<const V&>(result));
+            }
+        }
+        else
+        {
+            lruPart->putLocked(key, static_cast<const V&>(result));
+        }
+        return true;
+    }
 
-    ~ArcCache() override = default;
     //插入/更新缓存
-    void put(const K& key, const V& value) override
+    template <typename KK, typename VV>
+    void putInternal(KK&& key, VV&& value)
     {
         bool inGhost = checkGhostCache(key);
 
         if(!inGhost)
         {   
             //数据不在幽灵缓存中,同时插到LRU部分和LFU部分中
-            if(lruPart->put(key, value))
+            if(lruPart->put(static_cast<const K&>(key), static_cast<const V&>(value)))
             {
-                lfuPart->put(key, value);
+                lfuPart->put(std::forward<KK>(key), std::forward<VV>(value));
             }
         }
         else 
         {
             //数据在幽灵缓存中，直接插入到LRU部分中,访问次数为1
-            lruPart->put(key, value);
+            lruPart->put(std::forward<KK>(key), std::forward<VV>(value));
         }
     }
+
+public:
+    explicit ArcCache(size_t Capacity = 10, size_t TransformThreshold = 3)
+    : capacity(Capacity)
+    , transformThreshold(TransformThreshold)
+    , lruPart(std::make_unique<ArcLruPart<K, V>>(Capacity/2, TransformThreshold))
+    , lfuPart(std::make_unique<ArcLfuPart<K, V>>(Capacity/2, TransformThreshold))
+    {}
+
+    ~ArcCache() override = default;
+    //插入/更新缓存
+    void put(const K& key, const V& value) override
+    {
+        putInternal(key, value);
+    }
+    //右值版本：同时插入两部分时LRU部分拷贝一份，LFU部分直接移动
+    void put(K&& key, V&& value) override
+    {
+        putInternal(std::move(key), std::move(value));
+    }
+    //原地构造缓存数据：值只构造一次，之后与右值put相同
+    template <typename KK, typename... Args>
+    void emplace(KK&& key, Args&&... args)
+    {
+        putInternal(std::forward<KK>(key), V(std::forward<Args>(args)...));
+    }
     //获取缓存
     bool get(const K& key, V& value) override
     {
@@ -111,6 +181,81 @@ public:
         get(key, value);
         return value;
     }
+    //原地访问缓存值：命中时在持锁期间以const V&调用fn，不拷贝值
+    //只有LRU部分的数据达到转移阈值、需要复制到LFU部分时才拷贝一次
+    //fn返回后引用即失效，fn内不能再访问同一个缓存
+    template <typename F>
+    bool visit(const K& key, F&& fn)
+    {
+        checkGhostCache(key);
+
+        bool shouldTransform = false;
+        V transformValue{};
+        bool hit = lruPart->visit(key, [&](const V& value)
+        {
+            fn(value);
+            if(shouldTransform)transformValue = value;
+        }, shouldTransform);
+        if(hit)
+        {
+            if(shouldTransform)
+            {
+                lfuPart->put(key, transformValue);
+            }
+            return true;
+        }
+        return lfuPart->visit(key, std::forward<F>(fn));
+    }
+    //原子地读-改-写：fn(const V* old)返回新值，键不存在时old为nullptr，新值写入缓存并返回
+    //两个部分的锁在整个过程中同时持有；fn在持锁期间调用，fn内不能再访问同一个缓存
+    template <typename F>
+    V compute(const K& key, F&& fn)
+    {
+        V result{};
+        computeInternal(key, std::forward<F>(fn), false, result);
+        return result;
+    }
+    //键存在时以fn(const V& old)的返回值替换旧值，不存在时不写入，返回键是否存在
+    template <typename F>
+    bool computeIfPresent(const K& key, F&& fn)
+    {
+        V result{};
+        return computeInternal(key, [&](const V* old) -> V { return fn(*old); }, true, result);
+    }
+    //合并写入：键不存在时写入value，存在时写入fn(old, value)，返回写入的新值，适合计数器与聚合值
+    template <typename F>
+    V merge(const K& key, const V& value, F&& fn)
+    {
+        return compute(key, [&](const V* old) -> V { return old ? fn(*old, value) : value; });
+    }
+    //设置权重上限（字节数），0表示只按条目数限制
+    //与容量一样平分给LRU部分和LFU部分，各部分独立按权重淘汰；同一个键在两个部分中各存一份，权重也各计一次
+    void setMaxWeight(size_t maxWeight)
+    {
+        lruPart->setMaxWeight((maxWeight + 1) / 2);
+        lfuPart->setMaxWeight((maxWeight + 1) / 2);
+    }
+    //设置权重函数，两个部分共用
+    void setWeigher(const typename CacheWeight<K, V>::Weigher& weigher)
+    {
+        lruPart->setWeigher(weigher);
+        lfuPart->setWeigher(weigher);
+    }
+    //当前总权重，包含两个部分的幽灵节点
+    size_t totalWeight()
+    {
+        return lruPart->totalWeight() + lfuPart->totalWeight();
+    }
+};
+
+//按键的哈希值分片的ARC缓存，各切片独立加锁，分片逻辑见ShardedCache
+template <typename K, typename V>
+class HashArcCache : public ShardedCache<ArcCache<K, V>>
+{
+public:
+    //n：总容量；sliceNum：切片数量，向上取整为2的幂
+    HashArcCache(size_t n, int sliceNum)
+    : ShardedCache<ArcCache<K, V>>(n, sliceNum > 0 ? static_cast<size_t>(sliceNum) : 1) {}
 };
 
 }
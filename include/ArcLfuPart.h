@@ -1,12 +1,15 @@
 #ifndef MYCACHE_ARCLFUCACHE_H
 #define MYCACHE_ARCLFUCACHE_H
 
-#include <unordered_map>
 #include <memory>
 #include <mutex>
 #include <cstring>
-#include <list>
+#include <utility>
 #include "ArcNode.h"
+#include "CacheWeigher.h"
+#include "SlabArena.h"
+#include "FlatHashMap.h"
+#include "FreqBucketList.h"
 
 namespace mycache {
 
@@ -15,48 +18,85 @@ class ArcLfuPart
 {
 public:
     using NodeType = ArcNode<K, V>;
-    using NodePtr = std::shared_ptr<NodeType>;
-    using NodeMap = std::unordered_map<K, NodePtr>;
-    using FreqMap = std::unordered_map<size_t, std::list<NodePtr>>;
+    using NodePtr = NodeType*;
+    using NodeMap = FlatHashMap<K, NodePtr>;
+    using FreqList = FreqBucketList<NodeType>;
+    using Weigher = typename CacheWeight<K, V>::Weigher;
 
 private:
     size_t mainCapacity;            // 主缓存容量 
     size_t ghostCapacity;           // 幽灵缓存容量
-    size_t minFreq;                 // 最小访问频次
     size_t transformThreshold;      // 转移阈值
     std::mutex mtx;                 // 互斥锁
+    SlabArena arena;                // 节点与频次桶内存池
 
     NodeMap mainCache;              // 主缓存
     NodeMap ghostCache;             // 幽灵缓存
 
-    FreqMap freqListMap;            // 访问频次列表
+    FreqList freqList;              // 按频次升序排列的频次桶链表，表头即最小频次
 
     NodePtr ghostHead;              // 幽灵链表头结点
     NodePtr ghostTail;              // 幽灵链表尾结点
 
+    CacheWeight<K, V> weight;       // 按权重限制容量时的记账，幽灵节点不保留值，按键加空值的权重计入
+
 public:
     explicit ArcLfuPart(size_t capacity,  size_t TransformThreshold)
     : mainCapacity(capacity)
     , ghostCapacity(capacity)
-    , minFreq(0)
     , transformThreshold(TransformThreshold)
+    , freqList(&arena)
     {
+        mainCache.reserve(capacity);
+        ghostCache.reserve(capacity);
         initialiaze();
     }
 
-    bool put(const K& key, const V& value)
+    ~ArcLfuPart()
+    {
+        for(auto it = mainCache.begin(); it != mainCache.end(); ++it)
+        {
+            arena.destroy(it->second);
+        }
+        NodePtr node = ghostHead;
+        while(node != nullptr)
+        {
+            NodePtr next = node->next;
+            arena.destroy(node);
+            node = next;
+        }
+    }
+
+    template <typename KK, typename VV>
+    bool put(KK&& key, VV&& value)
     {
         // 如果主缓存容量为空，则返回false
         if(mainCapacity <= 0)return false;
 
         std::lock_guard<std::mutex> lock(mtx);
+        return putLocked(std::forward<KK>(key), std::forward<VV>(value));
+    }
+
+    // 本部分的互斥锁，供ArcCache在一次读-改-写中同时锁住两个部分
+    std::mutex& mutex() { return mtx; }
+
+    // 插入/更新缓存，调用者已持有mutex()
+    template <typename KK, typename VV>
+    bool putLocked(KK&& key, VV&& value)
+    {
+        if(mainCapacity <= 0)return false;
 
         auto it = mainCache.find(key);
         if(it != mainCache.end())
         {
-            return updateMainNode(it->second, value);
+            updateMainNode(it->second, std::forward<VV>(value));
+        }
+        else
+        {
+            addNewNode(std::forward<KK>(key), std::forward<VV>(value));
         }
-        return addNewNode(key, value);
+        trimToWeight();
+        return true;
     }
 
     bool get(const K& key, V& value)
@@ -82,13 +122,44 @@ public:
         return value;
     }
 
+    // 原地访问缓存值，持锁期间以const V&调用fn
+    template <typename F>
+    bool visit(const K& key, F&& fn)
+    {
+        if(mainCapacity <= 0)return false;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = mainCache.find(key);
+        if(it == mainCache.end())return false;
+        fn(it->second->getValue());
+        updateNodeFrequency(it->second);
+        return true;
+    }
+
+    // 查找主缓存中的值，不更新访问频次，调用者已持有mutex()
+    const V* findLocked(const K& key)
+    {
+        auto it = mainCache.find(key);
+        return it != mainCache.end() ? &it->second->getValue() : nullptr;
+    }
+
     bool checkGhost(const K& key)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return checkGhostLocked(key);
+    }
+
+    // 检查幽灵缓存，调用者已持有mutex()
+    bool checkGhostLocked(const K& key)
     {
         auto it = ghostCache.find(key);
         if(it != ghostCache.end())
         {
-            removeGhostNode(it->second);
-            ghostCache.erase(key);
+            NodePtr node = it->second;
+            removeGhostNode(node);
+            ghostCache.erase(it);
+            weight.sub(weight.weigh(node->key, node->value));
+            arena.destroy(node);
             return true;
         }
         return false;
@@ -96,10 +167,23 @@ public:
 
     void increaseCapacity()
     {
-        mainCapacity++;
+        std::lock_guard<std::mutex> lock(mtx);
+        increaseCapacityLocked();
     }
 
     bool decreaseCapacity()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return decreaseCapacityLocked();
+    }
+
+    // 调整容量，调用者已持有mutex()
+    void increaseCapacityLocked()
+    {
+        mainCapacity++;
+    }
+
+    bool decreaseCapacityLocked()
     {
         if(mainCapacity <= 0)
         {   
@@ -114,78 +198,86 @@ public:
         return true;
     }
 
+    // 设置本部分的权重上限，0表示只按条目数限制
+    void setMaxWeight(size_t maxWeight)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        weight.setMaxWeight(maxWeight);
+        trimToWeight();
+    }
+
+    // 设置权重函数并重新计算总权重
+    void setWeigher(Weigher weigher)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        weight.setWeigher(std::move(weigher));
+        weight.reset();
+        for(auto it = mainCache.begin(); it != mainCache.end(); ++it)
+        {
+            weight.add(weight.weigh(it->first, it->second->value));
+        }
+        for(auto it = ghostCache.begin(); it != ghostCache.end(); ++it)
+        {
+            weight.add(weight.weigh(it->first, it->second->value));
+        }
+        trimToWeight();
+    }
+
+    // 本部分的总权重，包含幽灵节点
+    size_t totalWeight()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return weight.total();
+    }
+
 private:
     void initialiaze()
     {
-        ghostHead = std::make_shared<NodeType>(K(), V());
-        ghostTail = std::make_shared<NodeType>(K(), V());
+        ghostHead = arena.create<NodeType>(K(), V());
+        ghostTail = arena.create<NodeType>(K(), V());
         ghostHead->next = ghostTail;
         ghostTail->prev = ghostHead;
     }
     // 添加新节点到主缓存中
-    bool addNewNode(const K& key, const V& value)
+    template <typename KK, typename VV>
+    bool addNewNode(KK&& key, VV&& value)
     {
+        //新写入的数据取代同一个键的幽灵节点
+        dropGhost(key);
         if(mainCache.size() >= mainCapacity){
             evictLeastFrequent();
         }
         
-        //将新节点添加到频率列表中
-        NodePtr node = std::make_shared<NodeType>(key, value);
-        if(freqListMap.find(1) == freqListMap.end()){
-            freqListMap[1] = std::list<NodePtr>();
-        }
-        freqListMap[1].push_back(node);
-        minFreq = 1;
+        //将新节点添加到频次为1的桶中
+        NodePtr node = arena.create<NodeType>(std::forward<KK>(key), std::forward<VV>(value));
+        freqList.pushNew(node);
 
-        mainCache[key] = node;
+        mainCache[node->key] = node;
+        weight.add(weight.weigh(node->key, node->value));
         return true;
     }
     // 更新主缓存中的节点
-    bool updateMainNode(NodePtr node, const V& value)
+    template <typename VV>
+    bool updateMainNode(NodePtr node, VV&& value)
     {
-        node->setValue(value);
+        weight.sub(weight.weigh(node->key, node->value));
+        node->setValue(std::forward<VV>(value));
+        weight.add(weight.weigh(node->key, node->value));
         updateNodeFrequency(node);
         return true;
     }   
-    // 更新节点的访问频次并移动到新链表中
+    // 更新节点的访问频次并移动到相邻的高一级频次桶
     void updateNodeFrequency(NodePtr node)
     {
-        size_t oldFreq = node->getAccessCount();
         node->increaseAccessCount();
-        size_t newFreq = node->getAccessCount();
-
-        //从旧链表中移除
-        auto &oldList = freqListMap[oldFreq];
-        oldList.remove(node);
-        if(oldList.empty()){
-            freqListMap.erase(oldFreq);
-            if(minFreq == oldFreq){
-                minFreq = newFreq;
-            }
-        }
-        
-        //添加到新链表中
-        if(freqListMap.find(newFreq) == freqListMap.end()){
-            freqListMap[newFreq] = std::list<NodePtr>();
-        }
-        freqListMap[newFreq].push_back(node);
+        freqList.increment(node);
     }
     // 移除访问频次最低的节点
     void evictLeastFrequent()
     {
-        auto &minFreqList = freqListMap[minFreq];
-        if(freqListMap.empty()||minFreqList.empty())return;
-
-        NodePtr node = minFreqList.front();
-        minFreqList.pop_front();
-
-        // 如果链表为空，则删除该链表
-        if(minFreqList.empty())
-        {
-            freqListMap.erase(minFreq);
-            //更新最小访问频次
-            minFreq = freqListMap.empty() ? 0 : freqListMap.begin()->first;
-        }
+        NodePtr node = freqList.front();
+        if(node == nullptr)return;
+        freqList.remove(node);
 
         // 将节点添加到幽灵缓存中
         if(ghostCache.size() >= ghostCapacity)
@@ -197,12 +289,31 @@ private:
         // 从主缓存中移除该节点
         mainCache.erase(node->getKey());
     }
+    // 删除键对应的幽灵节点（如果有）
+    void dropGhost(const K& key)
+    {
+        auto it = ghostCache.find(key);
+        if(it == ghostCache.end())return;
+        NodePtr node = it->second;
+        removeGhostNode(node);
+        ghostCache.erase(it);
+        weight.sub(weight.weigh(node->key, node->value));
+        arena.destroy(node);
+    }
     // 将节点添加到幽灵缓存中
     void addToGhost(NodePtr node)
     {
+        //同一个键还留有旧的幽灵节点时先将其删除，否则旧节点会留在幽灵链表中却不在索引里
+        dropGhost(node->key);
+
         //重置访问次数
         node->accessCount = 1;
 
+        //幽灵节点再次命中时直接删除，不再需要值，释放后按键加空值的权重计入
+        weight.sub(weight.weigh(node->key, node->value));
+        releaseValue(node->value);
+        weight.add(weight.weigh(node->key, node->value));
+
         //添加到幽灵链表尾部
         node->next = ghostTail;
         node->prev = ghostTail->prev;
@@ -225,6 +336,27 @@ private:
         NodePtr node = ghostHead->next;
         removeGhostNode(node);
         ghostCache.erase(node->getKey());
+        weight.sub(weight.weigh(node->key, node->value));
+        arena.destroy(node);
+    }
+    // 总权重超过上限时继续淘汰：幽灵节点不少于主缓存条目时删除最旧的幽灵节点，否则淘汰访问频次最低的数据
+    void trimToWeight()
+    {
+        while(weight.overLimit())
+        {
+            if(!ghostCache.empty() && ghostCache.size() >= mainCache.size())
+            {
+                evictOldestGhost();
+            }
+            else if(!mainCache.empty())
+            {
+                evictLeastFrequent();
+            }
+            else
+            {
+                break;
+            }
+        }
     }
 };
 }
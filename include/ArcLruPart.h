@@ -5,8 +5,12 @@
 #include <memory>
 #include <mutex>
 #include <cstring>
+#include <utility>
 
 #include "ArcNode.h"
+#include "CacheWeigher.h"
+#include "SlabArena.h"
+#include "FlatHashMap.h"
 
 namespace mycache {
 
@@ -14,14 +18,16 @@ template <typename K, typename V>
 class ArcLruPart{
 public:
     using NodeType = ArcNode<K, V>;
-    using NodePtr = std::shared_ptr<NodeType>;
-    using NodeMap = std::unordered_map<K, NodePtr>;
+    using NodePtr = NodeType*;
+    using NodeMap = FlatHashMap<K, NodePtr>;
+    using Weigher = typename CacheWeight<K, V>::Weigher;
 
 private:
     size_t mainCapacity;            //主缓存容量
     size_t ghostCapacity;           //幽灵缓存容量
     size_t transformThreshold;      //转移阈值
     std::mutex mtx;                //互斥锁
+    SlabArena arena;                //节点内存池
 
     NodeMap mainCache;              //主缓存
     NodeMap ghostCache;             //幽灵缓存
@@ -31,6 +37,8 @@ private:
     
     NodePtr ghostHead;              //幽灵链表虚拟头节点
     NodePtr ghostTail;              //幽灵链表虚拟尾节点
+
+    CacheWeight<K, V> weight;       //按权重限制容量时的记账，幽灵节点保留了值，按完整权重计入
     
 public:
     explicit ArcLruPart(size_t capacity, size_t TransformThreshold)
@@ -38,11 +46,20 @@ public:
     , ghostCapacity(capacity)
     , transformThreshold(TransformThreshold)
     {
+        mainCache.reserve(capacity);
+        ghostCache.reserve(capacity);
         initialize();
     }
 
+    ~ArcLruPart()
+    {
+        destroyList(mainHead);
+        destroyList(ghostHead);
+    }
+
     //插入/更新缓存
-    bool put(const K& key, const V& value)
+    template <typename KK, typename VV>
+    bool put(KK&& key, VV&& value)
     {
         if(mainCapacity <= 0)
         {
@@ -50,16 +67,33 @@ public:
         }
 
         std::lock_guard<std::mutex> lock(mtx);
+        return putLocked(std::forward<KK>(key), std::forward<VV>(value));
+    }
+
+    //本部分的互斥锁，供ArcCache在一次读-改-写中同时锁住两个部分
+    std::mutex& mutex() { return mtx; }
+
+    //插入/更新缓存，调用者已持有mutex()
+    template <typename KK, typename VV>
+    bool putLocked(KK&& key, VV&& value)
+    {
+        if(mainCapacity <= 0)
+        {
+            return false;
+        }
+
         auto it = mainCache.find(key);
         if(it != mainCache.end())
         {
             //更新缓存
-            updateMainNode(it->second, value);
+            updateMainNode(it->second, std::forward<VV>(value));
+            trimToWeight();
             return true;
         }
 
         //插入新缓存
-        addNewNode(key, value);
+        addNewNode(std::forward<KK>(key), std::forward<VV>(value));
+        trimToWeight();
         return true;
     }
 
@@ -83,6 +117,30 @@ public:
         return false;
     }
 
+    //原地访问缓存值，持锁期间以const V&调用fn，调用前已给出shouldTransform
+    template <typename F>
+    bool visit(const K& key, F&& fn, bool& shouldTransform)
+    {
+        if(mainCapacity <= 0)
+        {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = mainCache.find(key);
+        if(it == mainCache.end())return false;
+        shouldTransform = updateAccessCount(it->second);
+        fn(it->second->getValue());
+        return true;
+    }
+
+    //查找主缓存中的值，不更新访问状态，调用者已持有mutex()
+    const V* findLocked(const K& key)
+    {
+        auto it = mainCache.find(key);
+        return it != mainCache.end() ? &it->second->getValue() : nullptr;
+    }
+
     //获取缓存
     V get(const K& key)
     {
@@ -95,10 +153,20 @@ public:
     bool checkGhost(const K& key)
     {
         std::lock_guard<std::mutex> lock(mtx);
+        return checkGhostLocked(key);
+    }
+
+    //检查幽灵缓存，调用者已持有mutex()
+    bool checkGhostLocked(const K& key)
+    {
         auto it = ghostCache.find(key);
         if(it != ghostCache.end()){
-            removeGhostNode(it->second);
-            addNewNode(key, it->second->getValue());
+            NodePtr node = it->second;
+            removeGhostNode(node);
+            ghostCache.erase(it);
+            weight.sub(weight.weigh(node->key, node->value));
+            addNewNode(key, std::move(node->value));
+            arena.destroy(node);
             return true;
         }
         return false;
@@ -106,11 +174,23 @@ public:
 
     void increaseCapacity()
     {
-
-        mainCapacity++; 
+        std::lock_guard<std::mutex> lock(mtx);
+        increaseCapacityLocked();
     }
 
     bool decreaseCapacity()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return decreaseCapacityLocked();
+    }
+
+    //调整容量，调用者已持有mutex()
+    void increaseCapacityLocked()
+    {
+        mainCapacity++;
+    }
+
+    bool decreaseCapacityLocked()
     {
         if(mainCapacity <= 0)
         {   
@@ -127,19 +207,61 @@ public:
         return true;
     }
 
+    //设置本部分的权重上限，0表示只按条目数限制
+    void setMaxWeight(size_t maxWeight)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        weight.setMaxWeight(maxWeight);
+        trimToWeight();
+    }
+
+    //设置权重函数并重新计算总权重
+    void setWeigher(Weigher weigher)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        weight.setWeigher(std::move(weigher));
+        weight.reset();
+        for(auto it = mainCache.begin(); it != mainCache.end(); ++it)
+        {
+            weight.add(weight.weigh(it->first, it->second->value));
+        }
+        for(auto it = ghostCache.begin(); it != ghostCache.end(); ++it)
+        {
+            weight.add(weight.weigh(it->first, it->second->value));
+        }
+        trimToWeight();
+    }
+
+    //本部分的总权重，包含幽灵节点
+    size_t totalWeight()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return weight.total();
+    }
+
 private:
     void initialize()
     {
-        mainHead = std::make_shared<NodeType>(K(), V());
-        mainTail = std::make_shared<NodeType>(K(), V());
+        mainHead = arena.create<NodeType>(K(), V());
+        mainTail = arena.create<NodeType>(K(), V());
         mainHead->next = mainTail;
         mainTail->prev = mainHead;
 
-        ghostHead = std::make_shared<NodeType>(K(), V());
-        ghostTail = std::make_shared<NodeType>(K(), V());
+        ghostHead = arena.create<NodeType>(K(), V());
+        ghostTail = arena.create<NodeType>(K(), V());
         ghostHead->next = ghostTail;
         ghostTail->prev = ghostHead;
     }
+    //释放链表中的全部节点（含虚拟头尾节点）
+    void destroyList(NodePtr head)
+    {
+        while(head != nullptr)
+        {
+            NodePtr next = head->next;
+            arena.destroy(head);
+            head = next;
+        }
+    }
     //移除节点
     void removeNode(NodePtr node)
     {
@@ -161,22 +283,29 @@ private:
         addToMainTail(node);
     }
     //添加新节点到主缓存
-    bool addNewNode(const K& key, const V& value)
+    template <typename KK, typename VV>
+    bool addNewNode(KK&& key, VV&& value)
     {
+        //新写入的数据取代同一个键的幽灵节点
+        dropGhost(key);
         if(mainCache.size() >= mainCapacity)
         {
             //淘汰缓存
             evictLeastRecent();
         }
-        NodePtr node = std::make_shared<NodeType>(key, value);
+        NodePtr node = arena.create<NodeType>(std::forward<KK>(key), std::forward<VV>(value));
         addToMainTail(node);
-        mainCache[key] = node;
+        mainCache[node->key] = node;
+        weight.add(weight.weigh(node->key, node->value));
         return true;
     }
     //更新主链表中的节点
-    bool updateMainNode(NodePtr node, const V& value)
+    template <typename VV>
+    bool updateMainNode(NodePtr node, VV&& value)
     {
-        node->setValue(value);
+        weight.sub(weight.weigh(node->key, node->value));
+        node->setValue(std::forward<VV>(value));
+        weight.add(weight.weigh(node->key, node->value));
         moveToMainTail(node);
         return true;
     }
@@ -198,9 +327,23 @@ private:
     {
         removeNode(node);       
     }
+    //删除键对应的幽灵节点（如果有）
+    void dropGhost(const K& key)
+    {
+        auto it = ghostCache.find(key);
+        if(it == ghostCache.end())return;
+        NodePtr node = it->second;
+        removeGhostNode(node);
+        ghostCache.erase(it);
+        weight.sub(weight.weigh(node->key, node->value));
+        arena.destroy(node);
+    }
     //添加节点到幽灵缓存
     void addToGhost(NodePtr node)
     {
+        //同一个键还留有旧的幽灵节点时先将其删除，否则旧节点会留在幽灵链表中却不在索引里
+        dropGhost(node->key);
+
         //重置访问次数
         node->accessCount = 1;
 
@@ -222,6 +365,10 @@ private:
         }
         NodePtr node = mainHead->next;
 
+        //从主缓存中移除节点，必须先于挂入幽灵链表，否则前后指针已被改写
+        removeMainNode(node);
+        mainCache.erase(node->getKey());
+
         //添加到幽灵缓存
         if(ghostCache.size() >= ghostCapacity)
         {
@@ -229,10 +376,6 @@ private:
             evictOldestGhost();
         }
         addToGhost(node);
-
-        //从主缓存中移除节点
-        removeMainNode(node);
-        mainCache.erase(node->getKey());
     }
     //淘汰幽灵缓存中的最旧数据
     void evictOldestGhost()
@@ -242,6 +385,27 @@ private:
         NodePtr node = ghostHead->next;
         removeGhostNode(node);
         ghostCache.erase(node->getKey());
+        weight.sub(weight.weigh(node->key, node->value));
+        arena.destroy(node);
+    }
+    //总权重超过上限时继续淘汰：幽灵节点不少于主缓存条目时删除最旧的幽灵节点，否则把最久未使用的数据移入幽灵缓存
+    void trimToWeight()
+    {
+        while(weight.overLimit())
+        {
+            if(!ghostCache.empty() && ghostCache.size() >= mainCache.size())
+            {
+                evictOldestGhost();
+            }
+            else if(!mainCache.empty())
+            {
+                evictLeastRecent();
+            }
+            else
+            {
+                break;
+            }
+        }
     }
 
 };
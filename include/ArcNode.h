@@ -2,6 +2,9 @@
 #define MYCACHE_ARCNODECACHE_H
 
 #include <memory>
+#include <utility>
+
+#include "FreqBucketList.h"
 
 namespace mycache {
 
@@ -13,26 +16,31 @@ private:
     V value;
     bool dirty;
     size_t accessCount;                 //访问次数
-    std::shared_ptr<ArcNode<K,V>> prev;
-    std::shared_ptr<ArcNode<K,V>> next;
+    ArcNode<K,V>* prev;
+    ArcNode<K,V>* next;
+    FreqBucket<ArcNode<K,V>>* bucket;   //LFU部分中所属的频次桶
 public:
-    ArcNode(const K& k, const V& v) 
-    : key(k)
-    , value(v)
+    template <typename KK, typename VV>
+    ArcNode(KK&& k, VV&& v) 
+    : key(std::forward<KK>(k))
+    , value(std::forward<VV>(v))
     , dirty(false)
     , accessCount(1)
     , prev(nullptr)
-    , next(nullptr) {}
+    , next(nullptr)
+    , bucket(nullptr) {}
 
     //必要的访问工具
     K getKey() const { return key; }
-    V getValue() const { return value; }
+    const V& getValue() const { return value; }
     size_t getAccessCount() const { return accessCount; }   
     void setValue(const V& v) { value = v; }
+    void setValue(V&& v) { value = std::move(v); }
     void increaseAccessCount() { accessCount++; }
 
     template<typename Key, typename Value> friend class ArcLruPart;
     template<typename Key, typename Value> friend class ArcLfuPart;
+    template<typename Node> friend class FreqBucketList;
 };
 }
 #endif //MYCACHE_ARCNODECACHE_H
\ No newline at end of file
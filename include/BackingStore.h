@@ -0,0 +1,162 @@
+#ifndef MYCACHE_BACKINGSTORE_H
+#define MYCACHE_BACKINGSTORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace mycache {
+
+//缓存背后的持久存储，写回与读穿透都通过它访问
+//实现需要保证线程安全：后台写回线程与调用者线程可能同时访问
+template <typename K, typename V>
+class BackingStore
+{
+public:
+    virtual ~BackingStore() {}
+
+    //读取键对应的值，不存在时返回false
+    virtual bool load(const K& key, V& value) = 0;
+
+    //批量读取n个键：values[i]存放keys[i]的值，foundBits的第i位表示keys[i]是否存在（需要(n+63)/64个字），返回存在的个数
+    //默认逐个调用load，实现可重写为一次批量I/O；实现负责先清零foundBits
+    virtual size_t loadMany(const K* keys, size_t n, V* values, uint64_t* foundBits)
+    {
+        std::memset(foundBits, 0, (n + 63) / 64 * sizeof(uint64_t));
+        size_t found = 0;
+        for(size_t i = 0; i < n; ++i)
+        {
+            if(load(keys[i], values[i]))
+            {
+                foundBits[i / 64] |= uint64_t(1) << (i % 64);
+                ++found;
+            }
+        }
+        return found;
+    }
+
+    //写入一对键值
+    virtual void store(const K& key, const V& value) = 0;
+
+    //批量写入n对键值，默认逐个调用store，实现可重写为一次批量I/O
+    virtual void storeMany(const K* keys, const V* values, size_t n)
+    {
+        for(size_t i = 0; i < n; ++i)
+        {
+            store(keys[i], values[i]);
+        }
+    }
+};
+
+//键值与字节串之间的转换，FileBackingStore用它生成文件名与文件内容
+//默认支持可平凡复制的类型（按内存字节）与std::string，其他类型可特化
+template <typename T, typename Enable = void>
+struct StoreCodec;
+
+template <typename T>
+struct StoreCodec<T, typename std::enable_if<std::is_trivially_copyable<T>::value>::type>
+{
+    static std::string encode(const T& value)
+    {
+        return std::string(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    static bool decode(const std::string& bytes, T& value)
+    {
+        if(bytes.size() != sizeof(T))return false;
+        std::memcpy(&value, bytes.data(), sizeof(T));
+        return true;
+    }
+};
+
+template <>
+struct StoreCodec<std::string>
+{
+    static std::string encode(const std::string& value) { return value; }
+    static bool decode(const std::string& bytes, std::string& value)
+    {
+        value = bytes;
+        return true;
+    }
+};
+
+//基于本地目录的持久存储，用于测试与单机场景：每个键一个文件，文件名为编码后键的十六进制
+//写入先写临时文件再重命名，读者不会看到写了一半的文件
+template <typename K, typename V>
+class FileBackingStore : public BackingStore<K, V>
+{
+private:
+    std::filesystem::path dir;          //存放数据文件的目录
+    std::atomic<size_t> tmpSeq;         //临时文件序号，区分并发写入
+    std::atomic<size_t> loadCount;      //load调用次数
+    std::atomic<size_t> storeCount;     //写入的键值对数
+
+    std::filesystem::path pathOf(const K& key) const
+    {
+        static const char hex[] = "0123456789abcdef";
+        std::string bytes = StoreCodec<K>::encode(key);
+        std::string name;
+        name.reserve(bytes.size() * 2);
+        for(unsigned char c : bytes)
+        {
+            name.push_back(hex[c >> 4]);
+            name.push_back(hex[c & 0xf]);
+        }
+        return dir / (name.empty() ? std::string("_") : name);
+    }
+
+public:
+    explicit FileBackingStore(const std::string& directory)
+    : dir(directory)
+    , tmpSeq(0)
+    , loadCount(0)
+    , storeCount(0)
+    {
+        std::filesystem::create_directories(dir);
+    }
+
+    bool load(const K& key, V& value) override
+    {
+        loadCount.fetch_add(1, std::memory_order_relaxed);
+        std::ifstream in(pathOf(key), std::ios::binary);
+        if(!in)return false;
+        std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        return StoreCodec<V>::decode(bytes, value);
+    }
+
+    void store(const K& key, const V& value) override
+    {
+        std::filesystem::path target = pathOf(key);
+        std::filesystem::path tmp = target;
+        tmp += ".tmp" + std::to_string(tmpSeq.fetch_add(1, std::memory_order_relaxed));
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            std::string bytes = StoreCodec<V>::encode(value);
+            out.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+            if(!out)throw std::runtime_error("FileBackingStore: write failed: " + tmp.string());
+        }
+        std::filesystem::rename(tmp, target);
+        storeCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //删除目录中的全部数据文件
+    void clear()
+    {
+        for(const auto& entry : std::filesystem::directory_iterator(dir))
+        {
+            std::filesystem::remove(entry.path());
+        }
+    }
+
+    size_t loads() const { return loadCount.load(std::memory_order_relaxed); }
+    size_t stores() const { return storeCount.load(std::memory_order_relaxed); }
+};
+
+}
+#endif //MYCACHE_BACKINGSTORE_H
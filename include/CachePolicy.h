@@ -1,21 +1,110 @@
 #ifndef MYCACHE_CACHEPOLICY_H
 #define MYCACHE_CACHEPOLICY_H
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "SingleFlight.h"
+
 namespace mycache {
 
 template <typename K, typename V>
 class CachePolicy {
 public:
+    using key_type = K;
+    using mapped_type = V;
+
 	virtual ~CachePolicy() {}
     
     //向缓存中添加或更新键值对
     virtual void put(const K& key, const V& value) = 0;
 
+    //右值版本：键和值直接移动到缓存节点中，默认退化为拷贝版本，各策略重写为移动实现
+    virtual void put(K&& key, V&& value)
+    {
+        put(static_cast<const K&>(key), static_cast<const V&>(value));
+    }
+
     //根据键获取值，并更新该节点为最近使用的节点，访问成功返回true，否则返回false
 	virtual bool get(const K& key,V& value) = 0;
     
     //重载的 get 方法，直接返回值
 	virtual V get(const K& key) = 0;
+
+    //批量获取n个键：values[i]存放keys[i]的值，hitBits的第i位表示keys[i]是否命中（需要(n+63)/64个字），返回命中个数
+    size_t getMany(const K* keys, size_t n, V* values, uint64_t* hitBits)
+    {
+        std::memset(hitBits, 0, (n + 63) / 64 * sizeof(uint64_t));
+        return getBatch(keys, nullptr, n, values, hitBits);
+    }
+
+    //批量添加或更新n个键值对
+    void putMany(const K* keys, const V* values, size_t n)
+    {
+        putBatch(keys, values, nullptr, n);
+    }
+
+    //批量操作的扩展点：只处理order给出的n个下标（order为空时为0到n-1），values与hitBits按原下标访问
+    //默认逐个调用get/put，各策略可重写为只加一次锁，分片缓存按分片分组后转发
+    virtual size_t getBatch(const K* keys, const size_t* order, size_t n, V* values, uint64_t* hitBits)
+    {
+        size_t hits = 0;
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            if(get(keys[i], values[i]))
+            {
+                hitBits[i / 64] |= uint64_t(1) << (i % 64);
+                ++hits;
+            }
+        }
+        return hits;
+    }
+
+    virtual void putBatch(const K* keys, const V* values, const size_t* order, size_t n)
+    {
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            put(keys[i], values[i]);
+        }
+    }
+
+    //写入从存储加载的数据：键已在缓存中时保留缓存中的值，不覆盖可能更新的写入
+    //默认先get再put，两步之间不加锁；各策略重写为一次加锁内完成，且加载的数据不标记为脏，不会被写回
+    virtual void putLoaded(const K& key, const V& value)
+    {
+        V current{};
+        if(!get(key, current))put(key, value);
+    }
+
+    //加载前的复查：合并加载的领头者在读存储前再查一次缓存，行为与get相同，但不应算作一次新的访问
+    //默认调用get；按访问次数决定准入的策略（LRU-k）重写为不记录访问历史
+    virtual bool recheck(const K& key, V& value)
+    {
+        return get(key, value);
+    }
+
+    //读取缓存，未命中时调用loader(key)加载并写入缓存
+    //同一个键的并发未命中只会调用一次loader，其余线程等待并共享结果；命中路径仍只是一次get
+    //合并表见SharedLoadGroup，缓存对象本身不带合并加载的状态
+    template <typename F>
+    V getOrLoad(const K& key, F&& loader)
+    {
+        V value{};
+        if(get(key, value))return value;
+        return SharedLoadGroup<K, V>::run(this, key, [&]() -> V
+        {
+            //领头者再查一次，上一轮加载可能刚好在本线程未命中之后写入
+            V loaded{};
+            if(recheck(key, loaded))return loaded;
+            loaded = loader(key);
+            //加载的数据不标记为脏，也不覆盖加载期间其他线程写入的更新值
+            putLoaded(key, loaded);
+            return loaded;
+        });
+    }
 };
 }
 #endif
\ No newline at end of file
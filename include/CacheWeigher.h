@@ -0,0 +1,102 @@
+#ifndef MYCACHE_CACHEWEIGHER_H
+#define MYCACHE_CACHEWEIGHER_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mycache {
+
+//默认权重：对象本身的sizeof，加上string、vector在堆上占用的字节数
+template <typename T>
+struct DefaultWeigher
+{
+    size_t operator()(const T&) const { return sizeof(T); }
+};
+
+template <typename C, typename Tr, typename A>
+struct DefaultWeigher<std::basic_string<C, Tr, A>>
+{
+    size_t operator()(const std::basic_string<C, Tr, A>& s) const
+    {
+        //短字符串优化时数据存放在对象内部，已计入sizeof，只有数据在堆上时才加上容量
+        const char* data = reinterpret_cast<const char*>(s.data());
+        const char* self = reinterpret_cast<const char*>(&s);
+        std::less<const char*> before;
+        bool inlined = !before(data, self) && before(data, self + sizeof(s));
+        return inlined ? sizeof(s) : sizeof(s) + s.capacity() * sizeof(C);
+    }
+};
+
+template <typename T, typename A>
+struct DefaultWeigher<std::vector<T, A>>
+{
+    size_t operator()(const std::vector<T, A>& v) const
+    {
+        size_t weight = sizeof(v) + v.capacity() * sizeof(T);
+        if(!std::is_trivially_copyable<T>::value)
+        {   //元素自身还可能持有堆内存
+            DefaultWeigher<T> weigher;
+            for(const T& e : v)
+            {
+                weight += weigher(e) - sizeof(T);
+            }
+        }
+        return weight;
+    }
+};
+
+//清空值并释放它持有的内存
+//对string等类型直接赋值V()会保留原有的堆缓冲区，交换给临时对象后随临时对象一起析构
+template <typename T>
+void releaseValue(T& value)
+{
+    T empty{};
+    using std::swap;
+    swap(value, empty);
+}
+
+//按权重限制容量时的记账
+//maxWeight为0表示不限制权重，只按条目数淘汰；不为0时写入后若总权重超过上限，由缓存策略继续淘汰直到不超过
+//权重函数对同一对键值必须返回相同的结果，淘汰时会重新计算被淘汰数据的权重并从总权重中减去
+template <typename K, typename V>
+class CacheWeight
+{
+public:
+    using Weigher = std::function<size_t(const K&, const V&)>;
+
+private:
+    Weigher weigher;        //自定义权重函数，为空时使用DefaultWeigher
+    size_t maxWeight;       //权重上限，0表示不限制
+    size_t totalWeight;     //当前总权重
+
+public:
+    CacheWeight()
+    : maxWeight(0)
+    , totalWeight(0) {}
+
+    //计算一对键值的权重
+    size_t weigh(const K& key, const V& value) const
+    {
+        if(weigher)return weigher(key, value);
+        return DefaultWeigher<K>()(key) + DefaultWeigher<V>()(value);
+    }
+
+    void add(size_t weight) { totalWeight += weight; }
+    void sub(size_t weight) { totalWeight -= weight; }
+    void reset() { totalWeight = 0; }
+
+    void setWeigher(Weigher fn) { weigher = std::move(fn); }
+    void setMaxWeight(size_t weight) { maxWeight = weight; }
+
+    size_t total() const { return totalWeight; }
+    size_t max() const { return maxWeight; }
+    //总权重是否超过上限
+    bool overLimit() const { return maxWeight > 0 && totalWeight > maxWeight; }
+};
+
+}
+#endif //MYCACHE_CACHEWEIGHER_H
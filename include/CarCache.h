@@ -0,0 +1,408 @@
+#ifndef MYCACHE_CARCACHE_H
+#define MYCACHE_CARCACHE_H
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+
+#include "CachePolicy.h"
+#include "CacheWeigher.h"
+#include "SlabArena.h"
+#include "FlatHashMap.h"
+#include "ShardedCache.h"
+
+namespace mycache {
+
+//CAR中节点所在的时钟或幽灵链表
+enum class CarListId
+{
+    T1,     //冷时钟：最近只访问过一次的数据
+    T2,     //热时钟：至少访问过两次的数据
+    B1,     //从T1淘汰的幽灵键
+    B2      //从T2淘汰的幽灵键
+};
+
+//CAR节点，幽灵节点只保留键，值被重置
+template <typename K, typename V>
+struct CarNode
+{
+    K key;
+    V value;
+    bool reference;     //引用位，命中时置位
+    CarListId list;     //所在时钟或链表
+    CarNode* prev;
+    CarNode* next;
+    template <typename KK, typename... Args>
+    explicit CarNode(KK&& k, Args&&... args)
+    : key(std::forward<KK>(k)), value(std::forward<Args>(args)...), reference(false), list(CarListId::T1), prev(nullptr), next(nullptr) {}
+};
+
+//自适应Clock缓存CAR（Clock with Adaptive Replacement，Bansal & Modha）
+//ClockCache是单个时钟的二次机会算法，热点与扫描负载下远不如ARC；CAR用两个时钟代替ARC的T1/T2两条LRU链表：
+//  - 命中只置位引用位，不移动任何节点，与Clock一样临界区极短，而ARC每次命中都要把节点移到链表尾部
+//  - 缓存满时转动时钟：T1的大小不小于目标值p时检查T1的指针处，否则检查T2；
+//    引用位为0的数据降为幽灵键进入B1或B2，引用位为1的清零后进入T2尾部（T2内则相当于指针前进一格）
+//  - 幽灵键再次写入时按B1、B2的相对大小调整p，与ARC相同，B1命中增大冷时钟的份额，B2命中增大热时钟的份额
+//时钟用侵入式循环链表实现：表头即时钟指针，指针前进即把表头移到表尾；四个链表共用一张哈希索引
+template <typename K, typename V>
+class CarCache : public CachePolicy<K, V>
+{
+public:
+    using NodeType = CarNode<K, V>;
+    using NodePtr = NodeType*;
+    using NodeMap = FlatHashMap<K, NodePtr>;
+
+private:
+    //侵入式双向链表，表头为时钟指针（幽灵链表中为最旧的键），表尾为最近放入的位置
+    struct NodeList
+    {
+        NodePtr head = nullptr;
+        NodePtr tail = nullptr;
+        size_t size = 0;
+    };
+
+    size_t capacity;        //缓存容量c
+    size_t target;          //T1的目标大小p，在[0, c]之间自适应调整
+    std::mutex mtx;         //互斥锁
+    SlabArena arena;        //节点内存池
+    NodeMap nodeMap;        //键到节点的索引，包含幽灵节点
+    NodeList lists[4];      //按CarListId排列的两个时钟与两条幽灵链表
+
+private:
+    NodeList& listOf(CarListId id) { return lists[static_cast<int>(id)]; }
+
+    void pushBack(CarListId id, NodePtr node)
+    {
+        NodeList& list = listOf(id);
+        node->list = id;
+        node->next = nullptr;
+        node->prev = list.tail;
+        if(list.tail)list.tail->next = node;
+        else list.head = node;
+        list.tail = node;
+        list.size++;
+    }
+    void unlink(NodePtr node)
+    {
+        NodeList& list = listOf(node->list);
+        if(node->prev)node->prev->next = node->next;
+        else list.head = node->next;
+        if(node->next)node->next->prev = node->prev;
+        else list.tail = node->prev;
+        node->prev = nullptr;
+        node->next = nullptr;
+        list.size--;
+    }
+    void moveTo(CarListId id, NodePtr node)
+    {
+        unlink(node);
+        pushBack(id, node);
+    }
+    static bool isGhost(NodePtr node)
+    {
+        return node->list == CarListId::B1 || node->list == CarListId::B2;
+    }
+    //删除幽灵链表中最旧的键
+    void dropGhost(CarListId id)
+    {
+        NodePtr node = listOf(id).head;
+        if(node == nullptr)return;
+        unlink(node);
+        nodeMap.erase(node->key);
+        arena.destroy(node);
+    }
+    //转动时钟腾出一个位置：引用位为0的数据降为幽灵键，引用位为1的清零后移到T2尾部
+    //每转一步要么降级一条数据，要么清除一个引用位，最多转 |T1|+|T2|+1 步
+    void replace()
+    {
+        while(true)
+        {
+            NodeList& t1 = listOf(CarListId::T1);
+            if(t1.size > 0 && t1.size >= std::max<size_t>(target, 1))
+            {
+                NodePtr node = t1.head;
+                if(!node->reference)
+                {
+                    releaseValue(node->value);
+                    moveTo(CarListId::B1, node);
+                    return;
+                }
+                node->reference = false;
+                moveTo(CarListId::T2, node);
+            }
+            else
+            {
+                NodePtr node = listOf(CarListId::T2).head;
+                if(!node->reference)
+                {
+                    releaseValue(node->value);
+                    moveTo(CarListId::B2, node);
+                    return;
+                }
+                node->reference = false;
+                moveTo(CarListId::T2, node);
+            }
+        }
+    }
+    //全新的键：缓存已满时转动时钟，按需删除幽灵键，然后放入T1尾部，返回新节点
+    template <typename KK, typename... Args>
+    NodePtr addNewNode(KK&& key, Args&&... args)
+    {
+        if(listOf(CarListId::T1).size + listOf(CarListId::T2).size >= capacity)
+        {
+            replace();
+            //与论文一样按replace之后的各链表长度判断：T1与B1合计不超过c个，数据与幽灵键合计不超过2c个
+            size_t t1 = listOf(CarListId::T1).size;
+            size_t t2 = listOf(CarListId::T2).size;
+            size_t b1 = listOf(CarListId::B1).size;
+            size_t b2 = listOf(CarListId::B2).size;
+            if(t1 + b1 >= capacity)dropGhost(CarListId::B1);
+            else if(t1 + t2 + b1 + b2 >= 2 * capacity)dropGhost(CarListId::B2);
+        }
+        NodePtr node = arena.create<NodeType>(std::forward<KK>(key), std::forward<Args>(args)...);
+        nodeMap.emplace(node->key, node);
+        pushBack(CarListId::T1, node);
+        return node;
+    }
+    //幽灵键再次被写入：与论文一样先转动时钟腾出位置，再按此时B1、B2的长度调整p，之后带着新值进入T2尾部
+    template <typename... Args>
+    void reviveGhost(NodePtr node, Args&&... args)
+    {
+        if(listOf(CarListId::T1).size + listOf(CarListId::T2).size >= capacity)replace();
+        size_t b1 = listOf(CarListId::B1).size;
+        size_t b2 = listOf(CarListId::B2).size;
+        if(node->list == CarListId::B1)
+        {
+            target = std::min(capacity, target + std::max<size_t>(b2 / b1, 1));
+        }
+        else
+        {
+            size_t delta = std::max<size_t>(b1 / b2, 1);
+            target = target > delta ? target - delta : 0;
+        }
+        node->value = V(std::forward<Args>(args)...);
+        node->reference = false;
+        moveTo(CarListId::T2, node);
+    }
+    //添加或更新缓存，调用者已持有锁；命中只更新值并置位引用位
+    template <typename KK, typename... Args>
+    NodePtr putLocked(KK&& key, Args&&... args)
+    {
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end())return addNewNode(std::forward<KK>(key), std::forward<Args>(args)...);
+        NodePtr node = it->second;
+        if(isGhost(node))
+        {
+            reviveGhost(node, std::forward<Args>(args)...);
+            return node;
+        }
+        node->value = V(std::forward<Args>(args)...);
+        node->reference = true;
+        return node;
+    }
+    //获取缓存，调用者已持有锁；幽灵键没有数据，等调用者写入时再调整p
+    bool getLocked(const K& key, V& value)
+    {
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end() || isGhost(it->second))return false;
+        it->second->reference = true;
+        value = it->second->value;
+        return true;
+    }
+    //释放全部节点
+    void destroyAll()
+    {
+        for(auto it = nodeMap.begin(); it != nodeMap.end(); ++it)
+        {
+            arena.destroy(it->second);
+        }
+        nodeMap.clear();
+        for(NodeList& list : lists)
+        {
+            list = NodeList();
+        }
+    }
+
+public:
+    explicit CarCache(size_t n)
+    : capacity(n)
+    , target(0)
+    {
+        //数据与幽灵键合计最多2c个
+        nodeMap.reserve(2 * capacity);
+    }
+
+    ~CarCache() override
+    {
+        destroyAll();
+    }
+
+    void put(const K& key, const V& value) override
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        putLocked(key, value);
+    }
+
+    void put(K&& key, V&& value) override
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        putLocked(std::move(key), std::move(value));
+    }
+
+    //写入从存储加载的数据：数据已在缓存中时保留缓存中的值
+    void putLoaded(const K& key, const V& value) override
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = nodeMap.find(key);
+        if(it != nodeMap.end() && !isGhost(it->second))return;
+        putLocked(key, value);
+    }
+
+    //原地构造缓存数据：args直接用于构造值，键已存在时以新构造的值替换旧值
+    template <typename KK, typename... Args>
+    void emplace(KK&& key, Args&&... args)
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        putLocked(std::forward<KK>(key), std::forward<Args>(args)...);
+    }
+
+    bool get(const K& key, V& value) override
+    {
+        if(capacity <= 0)return false;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        return getLocked(key, value);
+    }
+
+    V get(const K& key) override
+    {
+        V value{};
+        get(key, value);
+        return value;
+    }
+
+    //原地访问缓存值：命中时在持锁期间以const V&调用fn，不拷贝值，并置位引用位
+    //fn返回后引用即失效，fn内不能再访问同一个缓存
+    template <typename F>
+    bool visit(const K& key, F&& fn)
+    {
+        if(capacity <= 0)return false;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end() || isGhost(it->second))return false;
+        it->second->reference = true;
+        fn(static_cast<const V&>(it->second->value));
+        return true;
+    }
+
+    //原子地读-改-写：fn(const V* old)返回新值，键不存在或只剩幽灵键时old为nullptr，新值写入缓存并返回
+    //查找、计算与写入在同一次加锁内完成；fn在持锁期间调用，fn内不能再访问同一个缓存
+    template <typename F>
+    V compute(const K& key, F&& fn)
+    {
+        if(capacity <= 0)return fn(static_cast<const V*>(nullptr));
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = nodeMap.find(key);
+        bool present = it != nodeMap.end() && !isGhost(it->second);
+        return putLocked(key, fn(present ? static_cast<const V*>(&it->second->value) : nullptr))->value;
+    }
+
+    //键存在时以fn(const V& old)的返回值替换旧值，不存在时不写入，返回键是否存在
+    template <typename F>
+    bool computeIfPresent(const K& key, F&& fn)
+    {
+        if(capacity <= 0)return false;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end() || isGhost(it->second))return false;
+        NodePtr node = it->second;
+        node->value = fn(static_cast<const V&>(node->value));
+        node->reference = true;
+        return true;
+    }
+
+    //合并写入：键不存在时写入value，存在时写入fn(old, value)，返回写入的新值，适合计数器与聚合值
+    template <typename F>
+    V merge(const K& key, const V& value, F&& fn)
+    {
+        return compute(key, [&](const V* old) -> V { return old ? fn(*old, value) : value; });
+    }
+
+    //批量获取，整批只加一次锁
+    size_t getBatch(const K* keys, const size_t* order, size_t n, V* values, uint64_t* hitBits) override
+    {
+        if(capacity <= 0)return 0;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t hits = 0;
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            if(getLocked(keys[i], values[i]))
+            {
+                hitBits[i / 64] |= uint64_t(1) << (i % 64);
+                ++hits;
+            }
+        }
+        return hits;
+    }
+
+    //批量添加或更新，整批只加一次锁
+    void putBatch(const K* keys, const V* values, const size_t* order, size_t n) override
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            putLocked(keys[i], values[i]);
+        }
+    }
+
+    //删除缓存数据，幽灵键也一并删除
+    bool remove(const K& key)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end())return false;
+        NodePtr node = it->second;
+        bool present = !isGhost(node);
+        unlink(node);
+        nodeMap.erase(it);
+        arena.destroy(node);
+        return present;
+    }
+
+    //清空缓存
+    void purge()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        destroyAll();
+        target = 0;
+    }
+};
+
+//分片CAR缓存，各分片独立加锁并各自调整p，分片逻辑见ShardedCache
+template <typename K, typename V>
+class HashCarCache : public ShardedCache<CarCache<K, V>>
+{
+public:
+    //n：总容量；sliceNum：切片数量，向上取整为2的幂
+    HashCarCache(size_t n, int sliceNum)
+    : ShardedCache<CarCache<K, V>>(n, sliceNum > 0 ? static_cast<size_t>(sliceNum) : 1) {}
+};
+
+}
+#endif //MYCACHE_CARCACHE_H
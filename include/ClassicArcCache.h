@@ -0,0 +1,557 @@
+#ifndef MYCACHE_CLASSICARCCACHE_H
+#define MYCACHE_CLASSICARCCACHE_H
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "CachePolicy.h"
+#include "CacheWeigher.h"
+#include "SlabArena.h"
+#include "FlatHashMap.h"
+#include "WriteBehind.h"
+
+namespace mycache {
+
+//经典ARC中节点所在的链表
+enum class ClassicArcListId
+{
+    T1,     //只访问过一次的缓存数据
+    T2,     //至少访问过两次的缓存数据
+    B1,     //从T1淘汰的幽灵键
+    B2      //从T2淘汰的幽灵键
+};
+
+//经典ARC节点，幽灵节点只保留键，值被重置
+template <typename K, typename V>
+struct ClassicArcNode
+{
+    K key;
+    V value;
+    bool dirty;                 //写入后尚未写回存储，幽灵节点总是干净的
+    ClassicArcListId list;      //所在链表
+    ClassicArcNode* prev;
+    ClassicArcNode* next;
+    template <typename KK, typename... Args>
+    explicit ClassicArcNode(KK&& k, Args&&... args)
+    : key(std::forward<KK>(k)), value(std::forward<Args>(args)...), dirty(false), list(ClassicArcListId::T1), prev(nullptr), next(nullptr) {}
+};
+
+//经典ARC缓存（Megiddo & Modha），T1/T2/B1/B2四条链表加自适应目标值p
+//与ArcCache不同，每个键只保存一份值，幽灵检查与数据访问在同一把锁内完成，每次操作只加一次锁
+//四条链表共用一张哈希索引，节点在链表之间移动时索引不变
+template <typename K, typename V>
+class ClassicArcCache : public CachePolicy<K, V>
+{
+public:
+    using NodeType = ClassicArcNode<K, V>;
+    using NodePtr = NodeType*;
+    using NodeMap = FlatHashMap<K, NodePtr>;
+    using Weigher = typename CacheWeight<K, V>::Weigher;
+
+private:
+    //侵入式双向链表，表头最久未使用，表尾最近使用
+    struct NodeList
+    {
+        NodePtr head = nullptr;
+        NodePtr tail = nullptr;
+        size_t size = 0;
+    };
+
+    size_t capacity;        //缓存容量c
+    size_t target;          //T1的目标大小p，在[0, c]之间自适应调整
+    std::mutex mtx;         //互斥锁
+    SlabArena arena;        //节点内存池
+    NodeMap nodeMap;        //键到节点的索引，包含幽灵节点
+    NodeList lists[4];      //按ClassicArcListId排列的四条链表
+    CacheWeight<K, V> weight;   //按权重限制容量时的记账，幽灵键按键加空值的权重计入
+    std::shared_ptr<WriteBehindQueue<K, V>> writeBack;  //脏数据写回队列，为空时淘汰直接丢弃数据
+
+private:
+    NodeList& listOf(ClassicArcListId id) { return lists[static_cast<int>(id)]; }
+
+    //追加到链表尾部（最近使用端）
+    void pushBack(ClassicArcListId id, NodePtr node)
+    {
+        NodeList& list = listOf(id);
+        node->list = id;
+        node->next = nullptr;
+        node->prev = list.tail;
+        if(list.tail)list.tail->next = node;
+        else list.head = node;
+        list.tail = node;
+        list.size++;
+    }
+    //从所在链表中摘下
+    void unlink(NodePtr node)
+    {
+        NodeList& list = listOf(node->list);
+        if(node->prev)node->prev->next = node->next;
+        else list.head = node->next;
+        if(node->next)node->next->prev = node->prev;
+        else list.tail = node->prev;
+        node->prev = nullptr;
+        node->next = nullptr;
+        list.size--;
+    }
+    //移动到另一条链表的尾部
+    void moveTo(ClassicArcListId id, NodePtr node)
+    {
+        unlink(node);
+        pushBack(id, node);
+    }
+    //节点是否为幽灵键
+    static bool isGhost(NodePtr node)
+    {
+        return node->list == ClassicArcListId::B1 || node->list == ClassicArcListId::B2;
+    }
+    //数据离开缓存时，脏数据的值移入写回队列，键仍留在节点中
+    void writeBackNode(NodePtr node)
+    {
+        if(writeBack && node->dirty)
+        {
+            writeBack->enqueue(static_cast<const K&>(node->key), std::move(node->value));
+        }
+        node->dirty = false;
+    }
+    //删除链表中最久未使用的节点，同时移出索引
+    void dropFront(ClassicArcListId id)
+    {
+        NodePtr node = listOf(id).head;
+        if(node == nullptr)return;
+        weight.sub(weight.weigh(node->key, node->value));
+        unlink(node);
+        nodeMap.erase(node->key);
+        writeBackNode(node);
+        arena.destroy(node);
+    }
+    //把T1或T2中最久未使用的数据降为幽灵键，放入对应的B1或B2
+    void demoteFront(ClassicArcListId from, ClassicArcListId to)
+    {
+        NodePtr node = listOf(from).head;
+        weight.sub(weight.weigh(node->key, node->value));
+        writeBackNode(node);
+        releaseValue(node->value);
+        weight.add(weight.weigh(node->key, node->value));
+        moveTo(to, node);
+    }
+    //替换数据节点的值并更新总权重
+    template <typename... Args>
+    void assignValue(NodePtr node, Args&&... args)
+    {
+        weight.sub(weight.weigh(node->key, node->value));
+        node->value = V(std::forward<Args>(args)...);
+        weight.add(weight.weigh(node->key, node->value));
+        node->dirty = true;
+    }
+    //REPLACE：缓存已满时腾出一个位置
+    void replace(bool hitInB2)
+    {
+        size_t t1 = listOf(ClassicArcListId::T1).size;
+        size_t t2 = listOf(ClassicArcListId::T2).size;
+        if(t1 + t2 < capacity)return;
+        evictData(hitInB2);
+    }
+    //把一条数据降为幽灵键：T1超过目标值p时淘汰T1，否则淘汰T2，调用者保证T1、T2不全为空
+    void evictData(bool hitInB2)
+    {
+        size_t t1 = listOf(ClassicArcListId::T1).size;
+        size_t t2 = listOf(ClassicArcListId::T2).size;
+        if(t1 > 0 && (t1 > target || (hitInB2 && t1 == target) || t2 == 0))
+        {
+            demoteFront(ClassicArcListId::T1, ClassicArcListId::B1);
+        }
+        else
+        {
+            demoteFront(ClassicArcListId::T2, ClassicArcListId::B2);
+        }
+    }
+    //幽灵键再次被写入：调整p，腾出位置后带着新值进入T2
+    template <typename... Args>
+    void reviveGhost(NodePtr node, Args&&... args)
+    {
+        size_t b1 = listOf(ClassicArcListId::B1).size;
+        size_t b2 = listOf(ClassicArcListId::B2).size;
+        bool inB2 = node->list == ClassicArcListId::B2;
+        if(!inB2)
+        {   //B1命中说明T1偏小，增大p
+            target = std::min(capacity, target + std::max<size_t>(b2 / b1, 1));
+        }
+        else
+        {   //B2命中说明T2偏小，减小p
+            size_t delta = std::max<size_t>(b1 / b2, 1);
+            target = target > delta ? target - delta : 0;
+        }
+        replace(inB2);
+        assignValue(node, std::forward<Args>(args)...);
+        moveTo(ClassicArcListId::T2, node);
+    }
+    //全新的键：按需删除幽灵键或淘汰数据，然后放入T1，返回新节点
+    template <typename KK, typename... Args>
+    NodePtr addNewNode(KK&& key, Args&&... args)
+    {
+        size_t t1 = listOf(ClassicArcListId::T1).size;
+        size_t b1 = listOf(ClassicArcListId::B1).size;
+        size_t total = t1 + b1 + listOf(ClassicArcListId::T2).size + listOf(ClassicArcListId::B2).size;
+        if(t1 + b1 >= capacity)
+        {
+            if(t1 < capacity)
+            {
+                dropFront(ClassicArcListId::B1);
+                replace(false);
+            }
+            else
+            {   //B1为空且T1已满，直接丢弃T1中最久未使用的数据
+                dropFront(ClassicArcListId::T1);
+            }
+        }
+        else if(total >= capacity)
+        {
+            if(total >= 2 * capacity)
+            {
+                dropFront(ClassicArcListId::B2);
+            }
+            replace(false);
+        }
+        NodePtr node = arena.create<NodeType>(std::forward<KK>(key), std::forward<Args>(args)...);
+        node->dirty = true;
+        nodeMap.emplace(node->key, node);
+        pushBack(ClassicArcListId::T1, node);
+        weight.add(weight.weigh(node->key, node->value));
+        return node;
+    }
+    //总权重超过上限时继续腾出空间
+    //幽灵键多于数据条目时删除较长幽灵链表中最旧的键，否则按REPLACE把一条数据降为幽灵键
+    //相当于把经典ARC中幽灵键不超过c个的约束里的c换成当前的数据条目数：值很大时幽灵键几乎不占预算
+    void trimToWeight()
+    {
+        while(weight.overLimit())
+        {
+            size_t b1 = listOf(ClassicArcListId::B1).size;
+            size_t b2 = listOf(ClassicArcListId::B2).size;
+            size_t t = listOf(ClassicArcListId::T1).size + listOf(ClassicArcListId::T2).size;
+            if(b1 + b2 > 0 && b1 + b2 >= t)
+            {
+                dropFront(b1 >= b2 ? ClassicArcListId::B1 : ClassicArcListId::B2);
+            }
+            else if(t > 0)
+            {
+                evictData(false);
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+    //添加或更新缓存，调用者已持有锁
+    template <typename KK, typename... Args>
+    void putLocked(KK&& key, Args&&... args)
+    {
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end())
+        {
+            addNewNode(std::forward<KK>(key), std::forward<Args>(args)...);
+        }
+        else if(!isGhost(it->second))
+        {   //缓存命中，更新值并移到T2尾部
+            NodePtr node = it->second;
+            assignValue(node, std::forward<Args>(args)...);
+            moveTo(ClassicArcListId::T2, node);
+        }
+        else
+        {
+            reviveGhost(it->second, std::forward<Args>(args)...);
+        }
+        trimToWeight();
+    }
+    //读-改-写缓存，调用者已持有锁：fn以旧值的指针计算新值，键不存在或只剩幽灵键时传入nullptr
+    //新值按put的方式写入并返回
+    template <typename F>
+    V computeLocked(const K& key, F&& fn)
+    {
+        V value;
+        auto it = nodeMap.find(key);
+        if(it != nodeMap.end() && !isGhost(it->second))
+        {
+            NodePtr node = it->second;
+            assignValue(node, fn(static_cast<const V*>(&node->value)));
+            moveTo(ClassicArcListId::T2, node);
+            value = node->value;
+        }
+        else
+        {
+            value = fn(static_cast<const V*>(nullptr));
+            if(it != nodeMap.end())reviveGhost(it->second, value);
+            else addNewNode(key, value);
+        }
+        trimToWeight();
+        return value;
+    }
+    //获取缓存，调用者已持有锁
+    bool getLocked(const K& key, V& value)
+    {
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end())return false;
+        NodePtr node = it->second;
+        if(isGhost(node))
+        {   //幽灵键没有数据，等调用者写入时再调整p
+            return false;
+        }
+        value = node->value;
+        moveTo(ClassicArcListId::T2, node);
+        return true;
+    }
+    //把T1、T2中的全部脏数据复制到写回队列并标记为干净，调用者已持有锁
+    void writeBackAll()
+    {
+        if(!writeBack)return;
+        for(ClassicArcListId id : {ClassicArcListId::T1, ClassicArcListId::T2})
+        {
+            for(NodePtr node = listOf(id).head; node != nullptr; node = node->next)
+            {
+                if(!node->dirty)continue;
+                writeBack->enqueue(node->key, node->value);
+                node->dirty = false;
+            }
+        }
+    }
+    //释放全部节点
+    void destroyAll()
+    {
+        for(auto it = nodeMap.begin(); it != nodeMap.end(); ++it)
+        {
+            arena.destroy(it->second);
+        }
+        nodeMap.clear();
+        for(NodeList& list : lists)
+        {
+            list = NodeList();
+        }
+        weight.reset();
+    }
+
+public:
+    explicit ClassicArcCache(size_t n)
+    : capacity(n)
+    , target(0)
+    {
+        //数据与幽灵键合计最多2c个
+        nodeMap.reserve(2 * capacity);
+    }
+
+    //析构时把未写回的脏数据交给写回队列
+    ~ClassicArcCache() override
+    {
+        writeBackAll();
+        destroyAll();
+    }
+
+    void put(const K& key, const V& value) override
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        putLocked(key, value);
+    }
+
+    //写入从存储加载的数据：键不存在或只剩幽灵键时写入且不标记为脏，数据已在缓存中时保留缓存中的值
+    void putLoaded(const K& key, const V& value) override
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        auto it = nodeMap.find(key);
+        if(it != nodeMap.end() && !isGhost(it->second))return;
+        NodePtr node;
+        if(it != nodeMap.end())
+        {
+            node = it->second;
+            reviveGhost(node, value);
+        }
+        else
+        {
+            node = addNewNode(key, value);
+        }
+        node->dirty = false;
+        trimToWeight();
+    }
+
+    void put(K&& key, V&& value) override
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        putLocked(std::move(key), std::move(value));
+    }
+
+    //原地构造缓存数据：args直接用于构造值，键已存在时以新构造的值替换旧值
+    template <typename KK, typename... Args>
+    void emplace(KK&& key, Args&&... args)
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        putLocked(std::forward<KK>(key), std::forward<Args>(args)...);
+    }
+
+    bool get(const K& key, V& value) override
+    {
+        if(capacity <= 0)return false;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        return getLocked(key, value);
+    }
+
+    V get(const K& key) override
+    {
+        V value{};
+        get(key, value);
+        return value;
+    }
+
+    //原地访问缓存值：命中时在持锁期间以const V&调用fn，不拷贝值，并与get一样移到T2
+    //fn返回后引用即失效，fn内不能再访问同一个缓存
+    template <typename F>
+    bool visit(const K& key, F&& fn)
+    {
+        if(capacity <= 0)return false;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end())return false;
+        NodePtr node = it->second;
+        if(isGhost(node))return false;
+        moveTo(ClassicArcListId::T2, node);
+        fn(static_cast<const V&>(node->value));
+        return true;
+    }
+
+    //原子地读-改-写：fn(const V* old)返回新值，键不存在时old为nullptr，新值写入缓存并返回
+    //查找、计算与写入在同一次加锁内完成；fn在持锁期间调用，fn内不能再访问同一个缓存
+    template <typename F>
+    V compute(const K& key, F&& fn)
+    {
+        if(capacity <= 0)return fn(static_cast<const V*>(nullptr));
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        return computeLocked(key, std::forward<F>(fn));
+    }
+
+    //键存在时以fn(const V& old)的返回值替换旧值，不存在时不写入，返回键是否存在
+    template <typename F>
+    bool computeIfPresent(const K& key, F&& fn)
+    {
+        if(capacity <= 0)return false;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end())return false;
+        NodePtr node = it->second;
+        if(isGhost(node))return false;
+        assignValue(node, fn(static_cast<const V&>(node->value)));
+        moveTo(ClassicArcListId::T2, node);
+        trimToWeight();
+        return true;
+    }
+
+    //合并写入：键不存在时写入value，存在时写入fn(old, value)，返回写入的新值，适合计数器与聚合值
+    template <typename F>
+    V merge(const K& key, const V& value, F&& fn)
+    {
+        return compute(key, [&](const V* old) -> V { return old ? fn(*old, value) : value; });
+    }
+
+    //批量获取，整批只加一次锁
+    size_t getBatch(const K* keys, const size_t* order, size_t n, V* values, uint64_t* hitBits) override
+    {
+        if(capacity <= 0)return 0;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t hits = 0;
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            if(getLocked(keys[i], values[i]))
+            {
+                hitBits[i / 64] |= uint64_t(1) << (i % 64);
+                ++hits;
+            }
+        }
+        return hits;
+    }
+
+    //批量添加或更新，整批只加一次锁
+    void putBatch(const K* keys, const V* values, const size_t* order, size_t n) override
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            putLocked(keys[i], values[i]);
+        }
+    }
+
+    //清空缓存
+    void purge()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        destroyAll();
+        target = 0;
+    }
+
+    //设置权重上限（字节数），0表示只按条目数限制；超出上限时立即淘汰
+    //两种限制同时生效：条目数的约束保持经典ARC的规则，总权重（含幽灵键）超过上限时按trimToWeight继续腾出空间
+    void setMaxWeight(size_t maxWeight)
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        weight.setMaxWeight(maxWeight);
+        trimToWeight();
+    }
+
+    //设置权重函数，已缓存的数据与幽灵键按新函数重新计算总权重
+    void setWeigher(Weigher weigher)
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        weight.setWeigher(std::move(weigher));
+        weight.reset();
+        for(auto it = nodeMap.begin(); it != nodeMap.end(); ++it)
+        {
+            weight.add(weight.weigh(it->first, it->second->value));
+        }
+        trimToWeight();
+    }
+
+    //当前总权重，包含幽灵键
+    size_t totalWeight()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return weight.total();
+    }
+
+    //开启写回：写入的数据标记为脏，脏数据被淘汰（降为幽灵键或直接丢弃）时放入写回队列，由队列的后台线程批量写回存储
+    //purge删除的数据不写回；传入空指针关闭写回
+    void setWriteBack(std::shared_ptr<WriteBehindQueue<K, V>> queue)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        writeBack = std::move(queue);
+    }
+
+    //把缓存中的脏数据全部交给写回队列，并阻塞到队列写回完成；数据仍保留在缓存中
+    void flush()
+    {
+        std::shared_ptr<WriteBehindQueue<K, V>> queue;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            writeBackAll();
+            queue = writeBack;
+        }
+        if(queue)queue->flush();
+    }
+};
+
+}
+#endif //MYCACHE_CLASSICARCCACHE_H
@@ -1,57 +1,276 @@
 #ifndef MYCACHE_CLOCKCACHE_H
 #define MYCACHE_CLOCKCACHE_H
-#include <Windows.h>
-#include <unordered_map>
+#include <algorithm>
 #include <memory>
 #include <mutex>
 #include <cstring>
 #include <cassert>
 #include <vector>
+#include <utility>
+#include <chrono>
 #include "CachePolicy.h"
+#include "CacheWeigher.h"
+#include "FlatHashMap.h"
+#include "ShardedCache.h"
+#include "TimingWheel.h"
+#include "WriteBehind.h"
 
 namespace mycache { 
 
-template <typename K, typename V>
-struct ClockNode
-{
-    K key;
-    V value;
-    bool reference;
-    bool dirty;
-    ClockNode(const K& k, const V& v) : key(k), value(v), reference(false), dirty(false) {}
-
-    void setValue(const V& v){value = v;}
-    K getKey() const { return key; }
-    V getValue() const { return value; }    
-};
-
+// Clock缓存，环按结构数组存放：键、值、定时节点各占一个连续数组，引用位、脏位、占用位各打包成一个位图
+// 时钟指针扫描时每次检查一个64位字，用位运算找出第一个已占用且引用位为0的槽位，并成批清除经过的引用位；
+// 缓存中全是最近访问过的数据时，每64个槽位只需几条指令，不必逐个槽位访问节点
+// 槽位在构造时一次分配，K和V需要可默认构造；删除、过期与淘汰只清除槽位的占用位（墓碑），不移动其他槽位，
+// 下标压入空闲槽位栈，之后的写入先弹出空闲槽位，栈空时才转动时钟指针，删除与命中一样是O(1)
 template <typename K, typename V>
 class ClockCache : public CachePolicy<K, V>
 {
 public:
-    using ClockNodePtr = std::shared_ptr<ClockNode<K, V>>;
-    using ClockNodeMap = std::unordered_map<K, size_t>;
-    using ClockNodeVector = std::vector<ClockNodePtr>;
+    using ClockNodeMap = FlatHashMap<K, size_t>;
+    using Weigher = typename CacheWeight<K, V>::Weigher;
 private:
-    ClockNodeMap nodeMap;       // 键到数组索引的映射
-    ClockNodeVector clockList;  // 缓存数组,环形链表
+    ClockNodeMap nodeMap;                   // 键到槽位下标的映射
+    std::vector<K> keys;                    // 各槽位的键
+    std::vector<V> values;                  // 各槽位的值
+    std::vector<TimerNode> timers;          // 各槽位挂在时间轮上的定时节点，数组不再扩容，地址固定
+    std::vector<uint64_t> referenceBits;    // 引用位图
+    std::vector<uint64_t> dirtyBits;        // 脏位图，写入后尚未写回存储的数据置位
+    std::vector<uint64_t> occupiedBits;     // 占用位图
     size_t capacity;            // 缓存容量
     size_t size;                // 当前缓存大小
+    std::vector<size_t> freeSlots;  // 空闲槽位栈，构造时预留容量，之后不再分配内存
     size_t clockHand;           // 时钟指针
     std::mutex mtx;             // 互斥锁
-public:
-    explicit ClockCache(size_t capacity) : capacity(capacity), size(0), clockHand(0) {}
-    ~ClockCache()override = default;
-    bool get(const K& key, V& value) override
+    CacheWeight<K, V> weight;   // 按权重限制容量时的记账
+    TimingWheel wheel;          // 过期时间轮
+    ExpireMode expireMode;      // 过期方式
+    uint32_t defaultTtl;        // 未指定过期时间的写入使用的存活刻度数，0表示不过期
+    std::shared_ptr<WriteBehindQueue<K, V>> writeBack;  // 脏数据写回队列，为空时淘汰直接丢弃数据
+private:
+    static bool testBit(const std::vector<uint64_t>& bits, size_t i)
+    {
+        return (bits[i >> 6] >> (i & 63)) & 1;
+    }
+    static void setBit(std::vector<uint64_t>& bits, size_t i)
+    {
+        bits[i >> 6] |= uint64_t(1) << (i & 63);
+    }
+    static void clearBit(std::vector<uint64_t>& bits, size_t i)
+    {
+        bits[i >> 6] &= ~(uint64_t(1) << (i & 63));
+    }
+    // 离开缓存的槽位是脏数据时把键值移入写回队列，槽位随后复用或清空
+    void writeBackSlot(size_t i)
+    {
+        if (writeBack && testBit(dirtyBits, i))
+            writeBack->enqueue(std::move(keys[i]), std::move(values[i]));
+        clearBit(dirtyBits, i);
+    }
+    // 把缓存中的全部脏数据复制到写回队列并标记为干净，调用者已持有锁；按脏位图逐字跳过干净的数据
+    void writeBackAll()
+    {
+        if (!writeBack)
+            return;
+        for (size_t w = 0; w < dirtyBits.size(); ++w)
+        {
+            for (uint64_t bits = dirtyBits[w]; bits != 0; bits &= bits - 1)
+            {
+                size_t i = (w << 6) + static_cast<size_t>(__builtin_ctzll(bits));
+                writeBack->enqueue(keys[i], values[i]);
+            }
+            dirtyBits[w] = 0;
+        }
+    }
+    // 转动时钟指针找到淘汰槽位并停在该处：从指针所在的字开始，每次取一个字中已占用且引用位为0的槽位，
+    // 找到时清除本字中经过的引用位，找不到时整字清除引用位后进入下一个字；调用者保证缓存非空
+    // 转完一圈后所有引用位都已清除，最多扫描容量加64个槽位
+    size_t sweep()
+    {
+        size_t words = occupiedBits.size();
+        size_t w = clockHand >> 6;
+        uint64_t mask = ~uint64_t(0) << (clockHand & 63);
+        while (true)
+        {
+            uint64_t candidates = occupiedBits[w] & ~referenceBits[w] & mask;
+            if (candidates != 0)
+            {
+                size_t bit = static_cast<size_t>(__builtin_ctzll(candidates));
+                referenceBits[w] &= ~(mask & ((uint64_t(1) << bit) - 1));
+                clockHand = (w << 6) + bit;
+                return clockHand;
+            }
+            referenceBits[w] &= ~mask;
+            w = w + 1 == words ? 0 : w + 1;
+            mask = ~uint64_t(0);
+        }
+    }
+    // 把全部槽位压入空闲槽位栈，下标小的先弹出
+    void resetFreeSlots()
+    {
+        freeSlots.clear();
+        for (size_t i = capacity; i > 0; --i)
+            freeSlots.push_back(i - 1);
+    }
+    // 清空下标处的槽位并压入空闲槽位栈，调用者已持有锁；先从索引与权重中删除，再把脏数据移入写回队列
+    void removeAt(size_t index, bool writeBackDirty)
+    {
+        wheel.cancel(&timers[index]);
+        nodeMap.erase(keys[index]);
+        weight.sub(weight.weigh(keys[index], values[index]));
+        if (writeBackDirty)
+            writeBackSlot(index);
+        releaseValue(keys[index]);
+        releaseValue(values[index]);
+        clearBit(occupiedBits, index);
+        clearBit(referenceBits, index);
+        clearBit(dirtyBits, index);
+        freeSlots.push_back(index);
+        size--;
+    }
+    // 淘汰下标处的数据，脏数据交给写回队列，调用者已持有锁
+    void evictAt(size_t index)
+    {
+        removeAt(index, true);
+    }
+    // 总权重超过上限时按时钟扫描继续淘汰：引用位为1的数据清零后跳过，删除第一个引用位为0的数据
+    void trimToWeight()
+    {
+        while (weight.overLimit() && size > 0)
+        {
+            evictAt(sweep());
+        }
+    }
+    // 处理已到期的数据并返回删除的条数，调用者已持有锁；没有设置过期时间的数据时不读取时钟
+    size_t expireDue()
+    {
+        if (wheel.empty())
+            return 0;
+        return wheel.advance(wheel.now(), [this](TimerNode* timer)
+        {
+            evictAt(static_cast<size_t>(timer - timers.data()));
+        });
+    }
+    // 访问后续期，只在按访问过期时生效
+    void touch(size_t index)
+    {
+        if (expireMode == ExpireMode::AfterAccess)
+            wheel.restart(&timers[index]);
+    }
+    // 访问缓存数据，调用者已持有锁
+    bool getLocked(const K& key, V& value)
     {
-        std::lock_guard<std::mutex> lock(mtx);
         auto it = nodeMap.find(key);
         if (it == nodeMap.end())
             return false;
-        value = clockList[it->second]->getValue();
-        clockList[it->second]->reference = true;
+        value = values[it->second];
+        setBit(referenceBits, it->second);
+        touch(it->second);
         return true;
     }
+    // 更新已有槽位的值，置位引用位并标记为脏
+    template <typename... Args>
+    void updateSlot(size_t index, Args&&... args)
+    {
+        weight.sub(weight.weigh(keys[index], values[index]));
+        values[index] = V(std::forward<Args>(args)...);
+        weight.add(weight.weigh(keys[index], values[index]));
+        setBit(referenceBits, index);
+        setBit(dirtyBits, index);
+    }
+    // 读-改-写缓存数据，调用者已持有锁：fn以旧值的指针（不存在时为nullptr）计算新值，写入并返回新值
+    template <typename F>
+    V computeLocked(const K& key, F&& fn)
+    {
+        V value;
+        auto it = nodeMap.find(key);
+        if (it != nodeMap.end())
+        {
+            size_t index = it->second;
+            updateSlot(index, fn(static_cast<const V*>(&values[index])));
+            wheel.restart(&timers[index]);
+            value = values[index];
+        }
+        else
+        {
+            value = fn(static_cast<const V*>(nullptr));
+            putEntry(defaultTtl, key, value);
+        }
+        trimToWeight();
+        return value;
+    }
+    // 添加或更新缓存数据并按权重淘汰，ttl为存活刻度数（0表示不过期），调用者已持有锁
+    template <typename KK, typename... Args>
+    void putLocked(uint32_t ttl, KK&& key, Args&&... args)
+    {
+        putEntry(ttl, std::forward<KK>(key), std::forward<Args>(args)...);
+        trimToWeight();
+    }
+    // 添加或更新缓存数据并安排过期，只按条目数淘汰，调用者已持有锁
+    template <typename KK, typename... Args>
+    void putEntry(uint32_t ttl, KK&& key, Args&&... args)
+    {
+        if (capacity == 0)
+            return;
+        wheel.schedule(&timers[writeEntry(std::forward<KK>(key), std::forward<Args>(args)...)], ttl);
+    }
+    // 添加或更新缓存数据，返回写入的槽位下标；调用者保证容量不为0
+    template <typename KK, typename... Args>
+    size_t writeEntry(KK&& key, Args&&... args)
+    {
+        auto it = nodeMap.find(key);
+        if (it != nodeMap.end())
+        {   // 存在，则更新槽位
+            updateSlot(it->second, std::forward<Args>(args)...);
+            return it->second;
+        }
+        bool atHand = freeSlots.empty();
+        if (atHand)
+        {   // 没有空槽，转动时钟指针淘汰一条数据，腾出的槽位随即被弹出复用；脏数据在evictAt中放入写回队列，由后台线程写回，这里不做I/O
+            evictAt(sweep());
+        }
+        size_t index = freeSlots.back();
+        freeSlots.pop_back();
+        if (atHand)
+            setBit(referenceBits, index);
+        keys[index] = std::forward<KK>(key);
+        values[index] = V(std::forward<Args>(args)...);
+        setBit(occupiedBits, index);
+        setBit(dirtyBits, index);
+        nodeMap[keys[index]] = index;
+        weight.add(weight.weigh(keys[index], values[index]));
+        size++;
+        return index;
+    }
+public:
+    explicit ClockCache(size_t capacity) 
+    : capacity(capacity)
+    , size(0)
+    , clockHand(0) 
+    , expireMode(ExpireMode::AfterWrite)
+    , defaultTtl(0)
+    {
+        nodeMap.reserve(capacity);
+        keys.resize(capacity);
+        values.resize(capacity);
+        timers.resize(capacity);
+        size_t words = (capacity + 63) / 64;
+        referenceBits.assign(words, 0);
+        dirtyBits.assign(words, 0);
+        occupiedBits.assign(words, 0);
+        freeSlots.reserve(capacity);
+        resetFreeSlots();
+    }
+    // 析构时把未写回的脏数据交给写回队列
+    ~ClockCache()override
+    {
+        writeBackAll();
+    }
+    bool get(const K& key, V& value) override
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        expireDue();
+        return getLocked(key, value);
+    }
 
     V get(const K& key) override
     {
@@ -60,77 +279,240 @@ public:
         return value;
     }
     void put(const K& key, const V& value) override
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        putLocked(defaultTtl, key, value);
+    }
+    // 右值版本，键和值移动到槽位中
+    void put(K&& key, V&& value) override
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        putLocked(defaultTtl, std::move(key), std::move(value));
+    }
+    // 添加缓存数据并指定存活时间，ttl为0表示不过期；按访问过期时每次访问以ttl续期
+    void put(const K& key, const V& value, std::chrono::milliseconds ttl)
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        putLocked(wheel.toTicks(ttl), key, value);
+    }
+    // 写入从存储加载的数据：键不存在时插入且不标记为脏，已存在时保留缓存中的值
+    void putLoaded(const K& key, const V& value) override
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        if (capacity == 0 || nodeMap.contains(key))
+            return;
+        size_t index = writeEntry(key, value);
+        clearBit(dirtyBits, index);
+        wheel.schedule(&timers[index], defaultTtl);
+        trimToWeight();
+    }
+    // 原地构造缓存数据：args直接用于构造值，键已存在时以新构造的值替换旧值
+    template <typename KK, typename... Args>
+    void emplace(KK&& key, Args&&... args)
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        putLocked(defaultTtl, std::forward<KK>(key), std::forward<Args>(args)...);
+    }
+    // 原地访问缓存值：命中时在持锁期间以const V&调用fn，不拷贝值，并置位引用位
+    // fn返回后引用即失效，fn内不能再访问同一个缓存
+    template <typename F>
+    bool visit(const K& key, F&& fn)
     {
         std::lock_guard<std::mutex> lock(mtx);
+        expireDue();
         auto it = nodeMap.find(key);
-        if (it != nodeMap.end())
-        {   // 存在，则更新节点
-            clockList[it->second]->setValue(value);
-            clockList[it->second]->reference = true;
-            clockList[it->second]->dirty = true;
-            return;
-        }
-        if (size < capacity)
-        {   // 还有容量，直接添加新节点
-            ClockNodePtr node = std::make_shared<ClockNode<K, V>>(key, value);
-            clockList.push_back(node);
-            nodeMap[key] = size;
-            size++;
-            return;
-        }
-        while (true)
-        {  
-            // 时钟指针指向的节点的引用位为1，将其置为0，指针后移
-            if (clockList[clockHand]->reference)
-            {
-                clockList[clockHand]->reference = false;
-                clockHand = (clockHand + 1) % capacity;
-            }
-            else
+        if (it == nodeMap.end())
+            return false;
+        setBit(referenceBits, it->second);
+        touch(it->second);
+        fn(static_cast<const V&>(values[it->second]));
+        return true;
+    }
+    // 原子地读-改-写：fn(const V* old)返回新值，键不存在时old为nullptr，新值写入缓存并返回
+    // 查找、计算与写入在同一次加锁内完成；fn在持锁期间调用，fn内不能再访问同一个缓存
+    template <typename F>
+    V compute(const K& key, F&& fn)
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        return computeLocked(key, std::forward<F>(fn));
+    }
+    // 键存在时以fn(const V& old)的返回值替换旧值，不存在时不写入，返回键是否存在
+    template <typename F>
+    bool computeIfPresent(const K& key, F&& fn)
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        auto it = nodeMap.find(key);
+        if (it == nodeMap.end())
+            return false;
+        size_t index = it->second;
+        updateSlot(index, fn(static_cast<const V&>(values[index])));
+        wheel.restart(&timers[index]);
+        trimToWeight();
+        return true;
+    }
+    // 合并写入：键不存在时写入value，存在时写入fn(old, value)，返回写入的新值，适合计数器与聚合值
+    template <typename F>
+    V merge(const K& key, const V& value, F&& fn)
+    {
+        return compute(key, [&](const V* old) -> V { return old ? fn(*old, value) : value; });
+    }
+    // 批量访问，整批只加一次锁
+    size_t getBatch(const K* keys, const size_t* order, size_t n, V* values, uint64_t* hitBits) override
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        expireDue();
+        size_t hits = 0;
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            if(getLocked(keys[i], values[i]))
             {
-                if (clockList[clockHand]->dirty)
-                {   // 脏节点，将其写回
-                    clockList[clockHand]->dirty = false;  
-                    //Sleep(1); // 模拟写回时间
-
-                    // 替换该节点
-                    nodeMap.erase(clockList[clockHand]->getKey());
-                    nodeMap[key] = clockHand;
-                    clockList[clockHand] = std::make_shared<ClockNode<K, V>>(key, value);
-                    clockList[clockHand]->reference = true;
-                    return;
-                }
-                else
-                {   // 该节点为干净节点，替换该节点
-                    nodeMap.erase(clockList[clockHand]->getKey());
-                    nodeMap[key] = clockHand;
-                    clockList[clockHand] = std::make_shared<ClockNode<K, V>>(key, value);
-                    clockList[clockHand]->reference = true;
-                    return;
-                }
+                hitBits[i / 64] |= uint64_t(1) << (i % 64);
+                ++hits;
             }
         }
+        return hits;
+    }
+    // 批量添加或更新，整批只加一次锁
+    void putBatch(const K* keys, const V* values, const size_t* order, size_t n) override
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            putLocked(defaultTtl, keys[i], values[i]);
+        }
     }
     void remove(const K& key)
     {
-        // 删除节点
+        // 删除数据，留下的空槽由之后的写入复用
         std::lock_guard<std::mutex> lock(mtx);
         auto it = nodeMap.find(key);
         if (it == nodeMap.end())
             return;
-        size_t index = it->second;
-        nodeMap.erase(key);
-        clockList.erase(clockList.begin() + index);
-        size--;
+        removeAt(it->second, false);
+    }
+    // 批量删除，整批只加一次锁，返回实际删除的条数；删除的数据不写回
+    size_t removeBatch(const K* keys, const size_t* order, size_t n)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t removed = 0;
+        for(size_t j = 0; j < n; ++j)
+        {
+            auto it = nodeMap.find(keys[order ? order[j] : j]);
+            if (it == nodeMap.end())
+                continue;
+            removeAt(it->second, false);
+            ++removed;
+        }
+        return removed;
+    }
+    // 按键集合批量失效n个键，返回实际删除的条数
+    size_t removeMany(const K* keys, size_t n)
+    {
+        return removeBatch(keys, nullptr, n);
     }
     void clear()
     {
         std::lock_guard<std::mutex> lock(mtx);
         nodeMap.clear();
-        clockList.clear();
+        wheel.clear();
+        for (size_t w = 0; w < occupiedBits.size(); ++w)
+        {
+            for (uint64_t bits = occupiedBits[w]; bits != 0; bits &= bits - 1)
+            {
+                size_t i = (w << 6) + static_cast<size_t>(__builtin_ctzll(bits));
+                releaseValue(keys[i]);
+                releaseValue(values[i]);
+            }
+        }
+        std::fill(referenceBits.begin(), referenceBits.end(), 0);
+        std::fill(dirtyBits.begin(), dirtyBits.end(), 0);
+        std::fill(occupiedBits.begin(), occupiedBits.end(), 0);
+        resetFreeSlots();
         size = 0;
+        clockHand = 0;
+        weight.reset();
+    }
+    // 设置权重上限（字节数），0表示只按条目数限制；超出上限时立即淘汰
+    // 两种限制同时生效：条目数达到容量或总权重超过上限都会触发淘汰
+    void setMaxWeight(size_t maxWeight)
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        weight.setMaxWeight(maxWeight);
+        trimToWeight();
+    }
+    // 设置权重函数，已缓存的数据按新函数重新计算总权重
+    void setWeigher(Weigher weigher)
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        weight.setWeigher(std::move(weigher));
+        weight.reset();
+        for (auto it = nodeMap.begin(); it != nodeMap.end(); ++it)
+        {
+            weight.add(weight.weigh(keys[it->second], values[it->second]));
+        }
+        trimToWeight();
+    }
+    // 当前总权重
+    size_t totalWeight()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return weight.total();
+    }
+    // 设置过期方式与默认存活时间，ttl为0表示未指定存活时间的写入不过期；只影响之后的写入
+    // AfterWrite：写入后经过ttl过期；AfterAccess：每次读写都以该数据自身的存活时间续期
+    void setExpiry(ExpireMode mode, std::chrono::milliseconds ttl)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        expireMode = mode;
+        defaultTtl = wheel.toTicks(ttl);
+    }
+    // 维护入口：立即删除已到期的数据，返回删除的条数；平时每次读写都会顺带处理
+    size_t cleanUp()
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        return expireDue();
+    }
+    // 开启写回：写入的数据标记为脏，脏数据被淘汰或过期时放入写回队列，由队列的后台线程批量写回存储
+    // remove与clear删除的数据不写回；传入空指针关闭写回
+    void setWriteBack(std::shared_ptr<WriteBehindQueue<K, V>> queue)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        writeBack = std::move(queue);
+    }
+    // 把缓存中的脏数据全部交给写回队列，并阻塞到队列写回完成；数据仍保留在缓存中
+    void flush()
+    {
+        std::shared_ptr<WriteBehindQueue<K, V>> queue;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            writeBackAll();
+            queue = writeBack;
+        }
+        if (queue)
+            queue->flush();
     }
 };
+
+//按键的哈希值分片的Clock缓存，各切片独立加锁，分片逻辑见ShardedCache
+template <typename K, typename V>
+class HashClockCache : public ShardedCache<ClockCache<K, V>>
+{
+public:
+    //n：总容量；sliceNum：切片数量，向上取整为2的幂
+    HashClockCache(size_t n, int sliceNum)
+    : ShardedCache<ClockCache<K, V>>(n, sliceNum > 0 ? static_cast<size_t>(sliceNum) : 1) {}
+};
+
 }
 
 #endif //MYCACHE_CLOCKCACHE_H
\ No newline at end of file
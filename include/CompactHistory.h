@@ -0,0 +1,140 @@
+#ifndef MYCACHE_COMPACTHISTORY_H
+#define MYCACHE_COMPACTHISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "HashUtil.h"
+
+namespace mycache {
+
+//定长的访问历史表，只保存键的指纹与访问次数，用于LRU-k判断是否准入
+//  - 每个64位字是一个桶，含4个16位槽：高12位为键的指纹，低4位为访问次数（上限15）
+//  - 键按哈希值落到一个桶，桶内按指纹查找；每个历史键只占2字节，不保存键本身
+//  - 桶满时做一次类似CLOCK的老化：桶内所有次数减去其中的最小值，次数降为0的槽让给新键
+//  - 指纹冲突会把两个键的次数合在一起，只会让键提前准入，不会漏掉访问
+//与SlabArena一样只在所属缓存的锁内使用，内部不加锁
+template <typename K>
+class CompactHistory
+{
+private:
+    static constexpr uint32_t SLOTS = 4;            //每个桶的槽数
+    static constexpr uint32_t COUNT_MASK = 0xf;     //槽内的次数位
+    static constexpr uint32_t MAX_COUNT = 15;
+
+    std::vector<uint64_t> buckets;  //桶数组，桶数为2的幂
+    size_t bucketMask;              //桶下标掩码
+
+private:
+    static uint64_t hashOf(const K& key)
+    {
+        return hashMix(static_cast<uint64_t>(std::hash<K>()(key)));
+    }
+    //指纹取哈希值的最高12位（与选桶用的低位无关），0留给空槽
+    static uint32_t fingerprintOf(uint64_t h)
+    {
+        uint32_t fp = static_cast<uint32_t>(h >> 48) & ~COUNT_MASK;
+        return fp != 0 ? fp : COUNT_MASK + 1;
+    }
+    static uint32_t slotAt(uint64_t word, uint32_t i)
+    {
+        return static_cast<uint32_t>(word >> (16 * i)) & 0xffff;
+    }
+    static void setSlot(uint64_t& word, uint32_t i, uint32_t slot)
+    {
+        word = (word & ~(uint64_t(0xffff) << (16 * i))) | (uint64_t(slot) << (16 * i));
+    }
+
+public:
+    //capacity：期望记录的历史键数，向上取整到4的倍数与2的幂
+    explicit CompactHistory(size_t capacity)
+    {
+        size_t bucketNum = 1;
+        while(bucketNum * SLOTS < capacity)bucketNum <<= 1;
+        buckets.assign(bucketNum, 0);
+        bucketMask = bucketNum - 1;
+    }
+
+    //记录一次访问，返回记录后的访问次数（1到15）
+    uint32_t record(const K& key)
+    {
+        uint64_t h = hashOf(key);
+        uint32_t fp = fingerprintOf(h);
+        uint64_t& word = buckets[h & bucketMask];
+        uint32_t freeSlot = SLOTS;
+        uint32_t minCount = MAX_COUNT;
+        for(uint32_t i = 0; i < SLOTS; ++i)
+        {
+            uint32_t slot = slotAt(word, i);
+            uint32_t count = slot & COUNT_MASK;
+            if((slot & ~COUNT_MASK) == fp && count > 0)
+            {
+                if(count < MAX_COUNT)++count;
+                setSlot(word, i, fp | count);
+                return count;
+            }
+            if(count == 0 && freeSlot == SLOTS)freeSlot = i;
+            if(count < minCount)minCount = count;
+        }
+        if(freeSlot == SLOTS)
+        {
+            //桶已满：所有槽的次数减去最小值，第一个降为0的槽给新键
+            for(uint32_t i = 0; i < SLOTS; ++i)
+            {
+                uint32_t slot = slotAt(word, i);
+                uint32_t count = (slot & COUNT_MASK) - minCount;
+                if(count == 0 && freeSlot == SLOTS)freeSlot = i;
+                setSlot(word, i, (slot & ~COUNT_MASK) | count);
+            }
+        }
+        setSlot(word, freeSlot, fp | 1);
+        return 1;
+    }
+
+    //键当前的访问次数，没有记录时为0
+    uint32_t count(const K& key) const
+    {
+        uint64_t h = hashOf(key);
+        uint32_t fp = fingerprintOf(h);
+        uint64_t word = buckets[h & bucketMask];
+        for(uint32_t i = 0; i < SLOTS; ++i)
+        {
+            uint32_t slot = slotAt(word, i);
+            if((slot & ~COUNT_MASK) == fp && (slot & COUNT_MASK) > 0)return slot & COUNT_MASK;
+        }
+        return 0;
+    }
+
+    //删除键的访问记录
+    void erase(const K& key)
+    {
+        uint64_t h = hashOf(key);
+        uint32_t fp = fingerprintOf(h);
+        uint64_t& word = buckets[h & bucketMask];
+        for(uint32_t i = 0; i < SLOTS; ++i)
+        {
+            uint32_t slot = slotAt(word, i);
+            if((slot & ~COUNT_MASK) == fp && (slot & COUNT_MASK) > 0)
+            {
+                setSlot(word, i, 0);
+                return;
+            }
+        }
+    }
+
+    void clear()
+    {
+        for(uint64_t& word : buckets)
+        {
+            word = 0;
+        }
+    }
+
+    //历史表占用的字节数
+    size_t bytes() const { return buckets.size() * sizeof(uint64_t); }
+};
+
+}
+#endif //MYCACHE_COMPACTHISTORY_H
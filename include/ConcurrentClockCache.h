@@ -0,0 +1,206 @@
+#ifndef MYCACHE_CONCURRENTCLOCKCACHE_H
+#define MYCACHE_CONCURRENTCLOCKCACHE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "CachePolicy.h"
+#include "ConcurrentIndex.h"
+
+namespace mycache {
+
+//读路径无锁的Clock缓存
+//命中只需要读出数据并置位引用位，不会调整任何结构，因此get完全不加锁：
+//  - 键到槽位的索引是一张线性探测的原子数组（ConcurrentIndex）
+//  - 每个槽位带一个顺序锁版本号（SeqlockEntry），读者拷贝键值后校验版本号，写者改写槽位期间版本号为奇数
+//  - 引用位为原子变量，读者用relaxed写入
+//put、remove与淘汰时的时钟扫描仍由互斥锁串行化
+//顺序锁读取要求按字节拷贝键值，因此K和V必须是可平凡拷贝的类型
+template <typename K, typename V>
+class ConcurrentClockCache : public CachePolicy<K, V>
+{
+    static_assert(std::is_trivially_copyable<K>::value, "ConcurrentClockCache requires a trivially copyable key");
+    static_assert(std::is_trivially_copyable<V>::value, "ConcurrentClockCache requires a trivially copyable value");
+
+private:
+    struct Slot : SeqlockEntry<K, V>
+    {
+        std::atomic<uint8_t> reference;     //引用位
+        bool occupied;                      //是否存有数据，只由持锁的写者访问
+        Slot() : reference(0), occupied(false) {}
+    };
+
+    size_t capacity;                                    //缓存容量
+    std::unique_ptr<Slot[]> slots;                      //槽位数组，即时钟环
+    ConcurrentIndex<K> index;                           //键到槽位的并发索引
+    std::vector<uint32_t> freeSlots;                    //被删除后空出的槽位
+    size_t size;                                        //已使用过的槽位数
+    size_t clockHand;                                   //时钟指针
+    std::mutex mtx;                                     //写者互斥锁
+
+private:
+    //在索引中查找键，返回索引项位置，不存在时返回NPOS，调用者持有写者锁
+    size_t findEntry(const K& key, uint32_t hash) const
+    {
+        return index.find(key, hash, [this](size_t slot) -> const K& { return slots[slot].key; });
+    }
+    //推进时钟指针找到淘汰槽位，调用者持有写者锁
+    size_t sweep()
+    {
+        //读者会并发置位引用位，最多扫描两圈后强制淘汰当前槽位
+        for(size_t step = 0; step < 2 * capacity; ++step)
+        {
+            Slot& slot = slots[clockHand];
+            if(slot.occupied && slot.reference.load(std::memory_order_relaxed) == 0)break;
+            slot.reference.store(0, std::memory_order_relaxed);
+            clockHand = (clockHand + 1) % capacity;
+        }
+        size_t victim = clockHand;
+        clockHand = (clockHand + 1) % capacity;
+        return victim;
+    }
+    //添加或更新缓存，调用者已持有写者锁
+    void putLocked(const K& key, const V& value)
+    {
+        uint32_t hash = ConcurrentIndex<K>::hashOf(key);
+        size_t pos = findEntry(key, hash);
+        if(pos != ConcurrentIndex<K>::NPOS)
+        {
+            // 存在，则原地更新槽位
+            Slot& slot = slots[index.slotAt(pos)];
+            slot.write(key, value);
+            slot.reference.store(1, std::memory_order_relaxed);
+            return;
+        }
+
+        size_t target;
+        if(!freeSlots.empty())
+        {   // 优先复用被删除的槽位
+            target = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else if(size < capacity)
+        {   // 还有容量，直接使用新槽位
+            target = size++;
+        }
+        else
+        {   // 时钟扫描淘汰旧数据，先从索引中删除，再改写槽位
+            target = sweep();
+            Slot& victim = slots[target];
+            index.erase(findEntry(victim.key, ConcurrentIndex<K>::hashOf(victim.key)));
+        }
+        Slot& slot = slots[target];
+        slot.write(key, value);
+        slot.occupied = true;
+        slot.reference.store(0, std::memory_order_relaxed);
+        index.insert(hash, target);
+    }
+
+public:
+    explicit ConcurrentClockCache(size_t n)
+    : capacity(n)
+    , index(n)
+    , size(0)
+    , clockHand(0)
+    {
+        assert(capacity < UINT32_MAX);
+        slots.reset(new Slot[capacity > 0 ? capacity : 1]);
+        freeSlots.reserve(capacity);
+    }
+    ~ConcurrentClockCache() override = default;
+
+    //无锁读取：探测索引，按顺序锁读出槽位并置位引用位
+    bool get(const K& key, V& value) override
+    {
+        if(capacity <= 0)return false;
+
+        return index.probe(ConcurrentIndex<K>::hashOf(key), [&](size_t i)
+        {
+            Slot& slot = slots[i];
+            if(!slot.read(key, value))return false;
+            slot.reference.store(1, std::memory_order_relaxed);
+            return true;
+        });
+    }
+
+    V get(const K& key) override
+    {
+        V value{};
+        get(key, value);
+        return value;
+    }
+
+    void put(const K& key, const V& value) override
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        putLocked(key, value);
+    }
+
+    //与其他策略接口一致的访问方式：值可平凡拷贝，按顺序锁读出副本后调用fn
+    template <typename F>
+    bool visit(const K& key, F&& fn)
+    {
+        V value;
+        if(!get(key, value))return false;
+        fn(static_cast<const V&>(value));
+        return true;
+    }
+
+    //与其他策略接口一致的原地构造：值可平凡拷贝，构造后按值写入
+    template <typename KK, typename... Args>
+    void emplace(KK&& key, Args&&... args)
+    {
+        put(K(std::forward<KK>(key)), V(std::forward<Args>(args)...));
+    }
+
+    //批量写入，整批只加一次写者锁；批量读取沿用逐个无锁读取的默认实现
+    void putBatch(const K* keys, const V* values, const size_t* order, size_t n) override
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            putLocked(keys[i], values[i]);
+        }
+    }
+
+    void remove(const K& key)
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t pos = findEntry(key, ConcurrentIndex<K>::hashOf(key));
+        if(pos == ConcurrentIndex<K>::NPOS)return;
+        size_t target = index.slotAt(pos);
+        index.erase(pos);
+        slots[target].occupied = false;
+        slots[target].reference.store(0, std::memory_order_relaxed);
+        freeSlots.push_back(static_cast<uint32_t>(target));
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        index.clear();
+        for(size_t i = 0; i < size; ++i)
+        {
+            slots[i].occupied = false;
+            slots[i].reference.store(0, std::memory_order_relaxed);
+        }
+        freeSlots.clear();
+        size = 0;
+        clockHand = 0;
+    }
+};
+
+}
+#endif //MYCACHE_CONCURRENTCLOCKCACHE_H
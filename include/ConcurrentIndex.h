@@ -0,0 +1,184 @@
+#ifndef MYCACHE_CONCURRENTINDEX_H
+#define MYCACHE_CONCURRENTINDEX_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+#include "HashUtil.h"
+
+namespace mycache {
+
+//带顺序锁的键值槽位，读路径无锁的缓存用它存放数据
+//写者改写期间版本号为奇数，读者按字节拷贝键值后校验版本号，因此K和V必须是可平凡拷贝的类型
+template <typename K, typename V>
+struct SeqlockEntry
+{
+    static_assert(std::is_trivially_copyable<K>::value, "SeqlockEntry requires a trivially copyable key");
+    static_assert(std::is_trivially_copyable<V>::value, "SeqlockEntry requires a trivially copyable value");
+
+    std::atomic<uint32_t> seq;      //顺序锁版本号，奇数表示正在写入
+    K key;
+    V value;
+
+    SeqlockEntry() : seq(0), key(), value() {}
+
+    //按顺序锁读取，键匹配时拷贝出值；version不为空时写入读到的版本号
+    bool read(const K& expected, V& out, uint32_t* version = nullptr) const
+    {
+        K k;
+        V v;
+        uint32_t before;
+        while(true)
+        {
+            before = seq.load(std::memory_order_acquire);
+            if(before & 1)
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            std::memcpy(static_cast<void*>(&k), &key, sizeof(K));
+            std::memcpy(static_cast<void*>(&v), &value, sizeof(V));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(seq.load(std::memory_order_relaxed) == before)break;
+        }
+        if(!(k == expected))return false;
+        out = v;
+        if(version)*version = before;
+        return true;
+    }
+    //按顺序锁改写，调用者持有写者锁
+    void write(const K& k, const V& v)
+    {
+        uint32_t current = seq.load(std::memory_order_relaxed);
+        seq.store(current + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(static_cast<void*>(&key), &k, sizeof(K));
+        std::memcpy(static_cast<void*>(&value), &v, sizeof(V));
+        seq.store(current + 2, std::memory_order_release);
+    }
+    //当前版本号，写者持锁时读取，用于判断槽位在读者记录之后是否被改写
+    uint32_t version() const { return seq.load(std::memory_order_relaxed); }
+};
+
+//键到槽位下标的并发索引：线性探测的原子数组，每项为 哈希标签(高32位)|槽位下标+1(低32位)
+//读者无锁探测，写者（插入、删除）由所属缓存的互斥锁串行化
+//索引只保存槽位下标，键的比较通过调用者提供的keyAt(slot)取槽位中的键
+template <typename K>
+class ConcurrentIndex
+{
+public:
+    static constexpr size_t NPOS = SIZE_MAX;    //查找失败
+
+private:
+    static constexpr uint64_t ENTRY_EMPTY = 0;  //空项
+
+    size_t tableMask;                                   //索引表大小减一
+    std::unique_ptr<std::atomic<uint64_t>[]> table;     //索引表
+
+    static uint64_t makeEntry(uint32_t hash, size_t slot)
+    {
+        return (static_cast<uint64_t>(hash) << 32) | static_cast<uint64_t>(slot + 1);
+    }
+    static uint32_t entryHash(uint64_t entry) { return static_cast<uint32_t>(entry >> 32); }
+    static size_t entrySlot(uint64_t entry) { return static_cast<size_t>(entry & 0xffffffffu) - 1; }
+
+public:
+    //capacity：最多同时存放的键数，索引表至少为其两倍，保证线性探测链较短
+    explicit ConcurrentIndex(size_t capacity)
+    : tableMask(0)
+    {
+        size_t tableSize = 16;
+        while(tableSize < capacity * 2)tableSize <<= 1;
+        tableMask = tableSize - 1;
+        table.reset(new std::atomic<uint64_t>[tableSize]);
+        for(size_t i = 0; i < tableSize; ++i)
+        {
+            table[i].store(ENTRY_EMPTY, std::memory_order_relaxed);
+        }
+    }
+
+    static uint32_t hashOf(const K& key)
+    {
+        uint64_t h = hashMix(static_cast<uint64_t>(std::hash<K>()(key)));
+        return static_cast<uint32_t>(h >> 32);
+    }
+
+    //无锁查找：按探测顺序对哈希标签相同的槽位调用tryMatch(slot)，返回true时停止并返回true
+    //搬移期间并发的读者可能短暂看不到被搬移的键，只会造成一次未命中
+    template <typename F>
+    bool probe(uint32_t hash, F&& tryMatch) const
+    {
+        for(size_t pos = hash & tableMask; ; pos = (pos + 1) & tableMask)
+        {
+            uint64_t entry = table[pos].load(std::memory_order_acquire);
+            if(entry == ENTRY_EMPTY)return false;
+            if(entryHash(entry) == hash && tryMatch(entrySlot(entry)))return true;
+        }
+    }
+
+    //查找键所在的索引项位置，不存在时返回NPOS，调用者持有写者锁
+    template <typename KeyAt>
+    size_t find(const K& key, uint32_t hash, KeyAt&& keyAt) const
+    {
+        for(size_t pos = hash & tableMask; ; pos = (pos + 1) & tableMask)
+        {
+            uint64_t entry = table[pos].load(std::memory_order_relaxed);
+            if(entry == ENTRY_EMPTY)return NPOS;
+            if(entryHash(entry) == hash && keyAt(entrySlot(entry)) == key)return pos;
+        }
+    }
+    //索引项指向的槽位下标，调用者持有写者锁
+    size_t slotAt(size_t pos) const
+    {
+        return entrySlot(table[pos].load(std::memory_order_relaxed));
+    }
+
+    //插入索引项，调用者持有写者锁
+    void insert(uint32_t hash, size_t slot)
+    {
+        size_t pos = hash & tableMask;
+        while(table[pos].load(std::memory_order_relaxed) != ENTRY_EMPTY)
+        {
+            pos = (pos + 1) & tableMask;
+        }
+        table[pos].store(makeEntry(hash, slot), std::memory_order_release);
+    }
+
+    //删除索引项，后移删除法，不留墓碑，调用者持有写者锁
+    void erase(size_t pos)
+    {
+        size_t hole = pos;
+        for(size_t next = (hole + 1) & tableMask; ; next = (next + 1) & tableMask)
+        {
+            uint64_t entry = table[next].load(std::memory_order_relaxed);
+            if(entry == ENTRY_EMPTY)break;
+            size_t home = entryHash(entry) & tableMask;
+            //home不在(hole, next]区间内时，该项可以前移填补空洞
+            bool movable = hole <= next ? (home <= hole || home > next) : (home <= hole && home > next);
+            if(movable)
+            {
+                table[hole].store(entry, std::memory_order_release);
+                hole = next;
+            }
+        }
+        table[hole].store(ENTRY_EMPTY, std::memory_order_release);
+    }
+
+    //清空索引，调用者持有写者锁
+    void clear()
+    {
+        for(size_t i = 0; i <= tableMask; ++i)
+        {
+            table[i].store(ENTRY_EMPTY, std::memory_order_release);
+        }
+    }
+};
+
+}
+#endif //MYCACHE_CONCURRENTINDEX_H
@@ -0,0 +1,258 @@
+#ifndef MYCACHE_CONCURRENTLRUCACHE_H
+#define MYCACHE_CONCURRENTLRUCACHE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "CachePolicy.h"
+#include "ConcurrentIndex.h"
+#include "ReadBuffer.h"
+
+namespace mycache {
+
+//读路径无锁、延迟调整顺序的LRU缓存
+//LruCache每次命中都要在锁内把节点移到链表尾部，只读的负载也完全串行；这里把命中与调整顺序拆开：
+//  - 查找与ConcurrentClockCache相同：无锁探测ConcurrentIndex，按顺序锁（SeqlockEntry）读出键值
+//  - 命中只把 槽位版本号|槽位下标 写入有损的分段读缓冲（ReadBuffer），读者从不等待链表
+//  - 分段写满时读者尝试try_lock，抢到锁的线程按批把缓冲中的命中回放到LRU链表；写入与maintain也会先回放
+//  - 回放时槽位版本号已变化（期间被改写或淘汰）的记录直接跳过
+//缓冲满时丢弃的命中只会让LRU顺序略有偏差，不影响数据正确性
+//顺序锁读取要求按字节拷贝键值，因此K和V必须是可平凡拷贝的类型
+template <typename K, typename V>
+class ConcurrentLruCache : public CachePolicy<K, V>
+{
+    static_assert(std::is_trivially_copyable<K>::value, "ConcurrentLruCache requires a trivially copyable key");
+    static_assert(std::is_trivially_copyable<V>::value, "ConcurrentLruCache requires a trivially copyable value");
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    struct Slot : SeqlockEntry<K, V>
+    {
+        uint32_t prev;      //LRU链表前驱，只由持锁的写者访问
+        uint32_t next;      //LRU链表后继
+        bool occupied;      //是否存有数据
+        Slot() : prev(NIL), next(NIL), occupied(false) {}
+    };
+
+    size_t capacity;                        //缓存容量
+    std::unique_ptr<Slot[]> slots;          //槽位数组
+    ConcurrentIndex<K> index;               //键到槽位的并发索引
+    ReadBuffer reads;                       //待回放的命中记录
+    std::vector<uint32_t> freeSlots;        //空闲槽位
+    uint32_t head;                          //最久未使用的槽位
+    uint32_t tail;                          //最近使用的槽位
+    size_t size;                            //缓存条目数
+    std::mutex mtx;                         //写者互斥锁，也保护LRU链表
+
+private:
+    static uint64_t makeRecord(uint32_t version, size_t slot)
+    {
+        return (static_cast<uint64_t>(version) << 32) | static_cast<uint64_t>(slot + 1);
+    }
+
+    size_t findEntry(const K& key, uint32_t hash) const
+    {
+        return index.find(key, hash, [this](size_t slot) -> const K& { return slots[slot].key; });
+    }
+    void unlink(uint32_t i)
+    {
+        Slot& slot = slots[i];
+        if(slot.prev != NIL)slots[slot.prev].next = slot.next;
+        else head = slot.next;
+        if(slot.next != NIL)slots[slot.next].prev = slot.prev;
+        else tail = slot.prev;
+        slot.prev = slot.next = NIL;
+    }
+    void pushBack(uint32_t i)
+    {
+        Slot& slot = slots[i];
+        slot.prev = tail;
+        slot.next = NIL;
+        if(tail != NIL)slots[tail].next = i;
+        else head = i;
+        tail = i;
+    }
+    void moveToRecent(uint32_t i)
+    {
+        if(tail == i)return;
+        unlink(i);
+        pushBack(i);
+    }
+    //把缓冲中的命中回放到LRU链表，调用者持有锁
+    size_t drainReads()
+    {
+        return reads.drain([this](uint64_t record)
+        {
+            uint32_t i = static_cast<uint32_t>(record & 0xffffffffu) - 1;
+            uint32_t version = static_cast<uint32_t>(record >> 32);
+            Slot& slot = slots[i];
+            if(slot.occupied && slot.version() == version)moveToRecent(i);
+        });
+    }
+    //添加或更新缓存，调用者已持有锁
+    void putLocked(const K& key, const V& value)
+    {
+        uint32_t hash = ConcurrentIndex<K>::hashOf(key);
+        size_t pos = findEntry(key, hash);
+        if(pos != ConcurrentIndex<K>::NPOS)
+        {
+            uint32_t i = static_cast<uint32_t>(index.slotAt(pos));
+            slots[i].write(key, value);
+            moveToRecent(i);
+            return;
+        }
+
+        uint32_t i;
+        if(size < capacity)
+        {
+            i = freeSlots.back();
+            freeSlots.pop_back();
+            ++size;
+        }
+        else
+        {   //淘汰最久未使用的数据，先从索引中删除，再改写槽位
+            i = head;
+            unlink(i);
+            index.erase(findEntry(slots[i].key, ConcurrentIndex<K>::hashOf(slots[i].key)));
+        }
+        Slot& slot = slots[i];
+        slot.write(key, value);
+        slot.occupied = true;
+        pushBack(i);
+        index.insert(hash, i);
+    }
+
+public:
+    explicit ConcurrentLruCache(size_t n)
+    : capacity(n)
+    , index(n)
+    , head(NIL)
+    , tail(NIL)
+    , size(0)
+    {
+        assert(capacity < NIL);
+        slots.reset(new Slot[capacity > 0 ? capacity : 1]);
+        freeSlots.reserve(capacity);
+        for(size_t i = capacity; i > 0; --i)
+        {
+            freeSlots.push_back(static_cast<uint32_t>(i - 1));
+        }
+    }
+    ~ConcurrentLruCache() override = default;
+
+    //无锁读取：探测索引，按顺序锁读出槽位，命中记入读缓冲；缓冲写满时尝试顺带回放
+    bool get(const K& key, V& value) override
+    {
+        if(capacity <= 0)return false;
+
+        uint32_t version = 0;
+        size_t hit = 0;
+        bool found = index.probe(ConcurrentIndex<K>::hashOf(key), [&](size_t i)
+        {
+            if(!slots[i].read(key, value, &version))return false;
+            hit = i;
+            return true;
+        });
+        if(!found)return false;
+        if(reads.record(makeRecord(version, hit)) >= ReadBuffer::STRIPE_SIZE && mtx.try_lock())
+        {
+            drainReads();
+            mtx.unlock();
+        }
+        return true;
+    }
+
+    V get(const K& key) override
+    {
+        V value{};
+        get(key, value);
+        return value;
+    }
+
+    void put(const K& key, const V& value) override
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        drainReads();
+        putLocked(key, value);
+    }
+
+    //与其他策略接口一致的访问方式：值可平凡拷贝，按顺序锁读出副本后调用fn
+    template <typename F>
+    bool visit(const K& key, F&& fn)
+    {
+        V value;
+        if(!get(key, value))return false;
+        fn(static_cast<const V&>(value));
+        return true;
+    }
+
+    //与其他策略接口一致的原地构造：值可平凡拷贝，构造后按值写入
+    template <typename KK, typename... Args>
+    void emplace(KK&& key, Args&&... args)
+    {
+        put(K(std::forward<KK>(key)), V(std::forward<Args>(args)...));
+    }
+
+    //批量写入，整批只加一次写者锁；批量读取沿用逐个无锁读取的默认实现
+    void putBatch(const K* keys, const V* values, const size_t* order, size_t n) override
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        drainReads();
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            putLocked(keys[i], values[i]);
+        }
+    }
+
+    void remove(const K& key)
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t pos = findEntry(key, ConcurrentIndex<K>::hashOf(key));
+        if(pos == ConcurrentIndex<K>::NPOS)return;
+        uint32_t i = static_cast<uint32_t>(index.slotAt(pos));
+        index.erase(pos);
+        unlink(i);
+        slots[i].occupied = false;
+        freeSlots.push_back(i);
+        --size;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        drainReads();
+        index.clear();
+        freeSlots.clear();
+        for(size_t i = capacity; i > 0; --i)
+        {
+            slots[i - 1].occupied = false;
+            slots[i - 1].prev = slots[i - 1].next = NIL;
+            freeSlots.push_back(static_cast<uint32_t>(i - 1));
+        }
+        head = tail = NIL;
+        size = 0;
+    }
+
+    //维护入口：把读缓冲中的命中全部回放到LRU链表，返回回放的条数；平时写入与读缓冲写满时会顺带回放
+    size_t maintain()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return drainReads();
+    }
+};
+
+}
+#endif //MYCACHE_CONCURRENTLRUCACHE_H
@@ -0,0 +1,391 @@
+#ifndef MYCACHE_FLATHASHMAP_H
+#define MYCACHE_FLATHASHMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#include <emmintrin.h>
+#define MYCACHE_FLATHASH_SSE2 1
+#endif
+
+#include "HashUtil.h"
+
+namespace mycache {
+
+//开放寻址的扁平哈希表（Swiss table结构），作为各缓存策略中键到节点的索引
+//控制字节数组与槽位数组分开存放，每个槽位保存键值对以及键的哈希值
+//控制字节存放哈希值的低7位，查找时以16个槽位为一组，先用SIMD比较控制字节，
+//只有控制字节匹配的槽位才会去比较键，插入和删除都不会分配内存
+template <typename K, typename T, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class FlatHashMap
+{
+public:
+    using key_type = K;
+    using mapped_type = T;
+    using value_type = std::pair<K, T>;
+
+private:
+    static constexpr size_t GROUP_WIDTH = 16;       //每组槽位数
+    static constexpr int8_t CTRL_EMPTY = -128;      //空槽位
+    static constexpr int8_t CTRL_DELETED = -2;      //已删除槽位（墓碑）
+
+    struct Slot
+    {
+        value_type kv;      //键值对
+        uint32_t hash;      //键的哈希值，扩容时无需重新计算
+    };
+
+    //一组控制字节的匹配工具，返回值的第i位表示组内第i个槽位是否匹配
+    class Group
+    {
+    private:
+#ifdef MYCACHE_FLATHASH_SSE2
+        __m128i ctrl;
+#else
+        const int8_t* ctrl;
+#endif
+    public:
+#ifdef MYCACHE_FLATHASH_SSE2
+        explicit Group(const int8_t* p) : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))) {}
+        //匹配控制字节等于h2的槽位
+        uint32_t match(int8_t h2) const
+        {
+            return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2))));
+        }
+        //匹配空槽位
+        uint32_t matchEmpty() const
+        {
+            return match(CTRL_EMPTY);
+        }
+        //匹配空槽位或已删除槽位，两者的最高位都为1
+        uint32_t matchFree() const
+        {
+            return static_cast<uint32_t>(_mm_movemask_epi8(ctrl));
+        }
+#else
+        explicit Group(const int8_t* p) : ctrl(p) {}
+        uint32_t match(int8_t h2) const
+        {
+            uint32_t bits = 0;
+            for(size_t i = 0; i < GROUP_WIDTH; ++i)
+            {
+                if(ctrl[i] == h2)bits |= 1u << i;
+            }
+            return bits;
+        }
+        uint32_t matchEmpty() const
+        {
+            return match(CTRL_EMPTY);
+        }
+        uint32_t matchFree() const
+        {
+            uint32_t bits = 0;
+            for(size_t i = 0; i < GROUP_WIDTH; ++i)
+            {
+                if(ctrl[i] < 0)bits |= 1u << i;
+            }
+            return bits;
+        }
+#endif
+    };
+
+    //取出最低位1的下标并清除该位
+    static size_t popLowest(uint32_t& bits)
+    {
+        size_t index = static_cast<size_t>(__builtin_ctz(bits));
+        bits &= bits - 1;
+        return index;
+    }
+
+public:
+    //前向迭代器，只遍历占用中的槽位
+    class iterator
+    {
+    private:
+        FlatHashMap* map;
+        size_t index;
+
+        void skipFree()
+        {
+            while(index < map->ctrl.size() && map->ctrl[index] < 0)++index;
+        }
+
+    public:
+        iterator() : map(nullptr), index(0) {}
+        iterator(FlatHashMap* m, size_t i, bool skip = false) : map(m), index(i)
+        {
+            if(skip)skipFree();
+        }
+
+        value_type& operator*() const { return map->slots[index].kv; }
+        value_type* operator->() const { return &map->slots[index].kv; }
+        iterator& operator++()
+        {
+            ++index;
+            skipFree();
+            return *this;
+        }
+        bool operator==(const iterator& other) const { return index == other.index; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+
+        friend class FlatHashMap;
+    };
+
+private:
+    std::vector<int8_t> ctrl;   //控制字节：空、已删除或哈希值低7位
+    std::vector<Slot> slots;    //槽位数组
+    size_t elemNum;             //键值对数量
+    size_t deleted;             //墓碑数量
+    size_t growthLimit;         //占用与墓碑之和的上限，负载因子为7/8
+    Hash hasher;
+    KeyEqual keyEqual;
+
+private:
+    uint32_t hashOf(const K& key) const
+    {
+        uint64_t h = hashMix(static_cast<uint64_t>(hasher(key)));
+        return static_cast<uint32_t>(h ^ (h >> 32));
+    }
+    static int8_t h2Of(uint32_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+    size_t groupMask() const { return ctrl.size() / GROUP_WIDTH - 1; }
+
+    //查找键所在槽位，不存在时返回槽位总数
+    size_t findIndex(const K& key, uint32_t hash) const
+    {
+        size_t mask = groupMask();
+        size_t group = (hash >> 7) & mask;
+        int8_t h2 = h2Of(hash);
+        for(size_t step = 1; ; ++step)
+        {
+            Group g(&ctrl[group * GROUP_WIDTH]);
+            uint32_t bits = g.match(h2);
+            while(bits)
+            {
+                size_t index = group * GROUP_WIDTH + popLowest(bits);
+                if(slots[index].hash == hash && keyEqual(slots[index].kv.first, key))
+                {
+                    return index;
+                }
+            }
+            //组内还有空槽位，说明该键从未越过这一组
+            if(g.matchEmpty())
+            {
+                return ctrl.size();
+            }
+            group = (group + step) & mask;
+        }
+    }
+    //沿探测序列找到第一个可写入的槽位（空槽位或墓碑）
+    size_t findFreeIndex(uint32_t hash) const
+    {
+        size_t mask = groupMask();
+        size_t group = (hash >> 7) & mask;
+        for(size_t step = 1; ; ++step)
+        {
+            uint32_t bits = Group(&ctrl[group * GROUP_WIDTH]).matchFree();
+            if(bits)
+            {
+                return group * GROUP_WIDTH + popLowest(bits);
+            }
+            group = (group + step) & mask;
+        }
+    }
+    //计算容纳n个元素所需的槽位数，为组大小的2的幂倍
+    static size_t slotNumFor(size_t n)
+    {
+        size_t need = n + n / 7 + 1;
+        size_t slotNum = GROUP_WIDTH;
+        while(slotNum < need)slotNum <<= 1;
+        return slotNum;
+    }
+    //重新分配槽位数组并搬迁全部键值对，同时清除墓碑
+    void rehash(size_t slotNum)
+    {
+        std::vector<int8_t> oldCtrl(slotNum, CTRL_EMPTY);
+        std::vector<Slot> oldSlots(slotNum);
+        oldCtrl.swap(ctrl);
+        oldSlots.swap(slots);
+        deleted = 0;
+        growthLimit = slotNum - slotNum / 8;
+        for(size_t i = 0; i < oldCtrl.size(); ++i)
+        {
+            if(oldCtrl[i] < 0)continue;
+            size_t index = findFreeIndex(oldSlots[i].hash);
+            ctrl[index] = h2Of(oldSlots[i].hash);
+            slots[index].kv = std::move(oldSlots[i].kv);
+            slots[index].hash = oldSlots[i].hash;
+        }
+    }
+    //不改变槽位数，原地清除墓碑并把键值对重新放回探测序列中尽量靠前的位置，不分配内存
+    void dropTombstones()
+    {
+        //先把墓碑变为空槽位，把占用槽位标记为待放置（借用墓碑标记）
+        for(size_t i = 0; i < ctrl.size(); ++i)
+        {
+            ctrl[i] = ctrl[i] == CTRL_DELETED || ctrl[i] == CTRL_EMPTY ? CTRL_EMPTY : CTRL_DELETED;
+        }
+        for(size_t i = 0; i < ctrl.size(); ++i)
+        {
+            if(ctrl[i] != CTRL_DELETED)continue;
+            uint32_t hash = slots[i].hash;
+            size_t target = findFreeIndex(hash);
+            if(target / GROUP_WIDTH == i / GROUP_WIDTH)
+            {
+                //探测序列中第一个可写入的组就是当前组，原地保留
+                ctrl[i] = h2Of(hash);
+            }
+            else if(ctrl[target] == CTRL_EMPTY)
+            {
+                //移动到更靠前的空槽位
+                ctrl[target] = h2Of(hash);
+                slots[target].kv = std::move(slots[i].kv);
+                slots[target].hash = hash;
+                slots[i].kv = value_type();
+                ctrl[i] = CTRL_EMPTY;
+            }
+            else
+            {
+                //目标槽位中是另一个待放置的键值对，交换后重新处理当前槽位
+                ctrl[target] = h2Of(hash);
+                std::swap(slots[target], slots[i]);
+                --i;
+            }
+        }
+        deleted = 0;
+    }
+    //插入前保证还有可写入的槽位
+    void prepareInsert()
+    {
+        if(elemNum + deleted < growthLimit)return;
+        //实际元素不多（不超过槽位数的25/32）时原地清理墓碑，否则扩容一倍
+        if(elemNum <= ctrl.size() * 25 / 32)
+        {
+            dropTombstones();
+        }
+        else
+        {
+            rehash(ctrl.size() * 2);
+        }
+    }
+    //删除指定槽位中的键值对
+    void eraseIndex(size_t index)
+    {
+        //所在组内仍有空槽位时，任何键的探测都不会越过这一组，可直接置空而不留墓碑
+        size_t groupStart = index / GROUP_WIDTH * GROUP_WIDTH;
+        if(Group(&ctrl[groupStart]).matchEmpty())
+        {
+            ctrl[index] = CTRL_EMPTY;
+        }
+        else
+        {
+            ctrl[index] = CTRL_DELETED;
+            ++deleted;
+        }
+        slots[index].kv = value_type();
+        --elemNum;
+    }
+
+public:
+    FlatHashMap()
+    : ctrl(GROUP_WIDTH, CTRL_EMPTY)
+    , slots(GROUP_WIDTH)
+    , elemNum(0)
+    , deleted(0)
+    , growthLimit(GROUP_WIDTH - GROUP_WIDTH / 8) {}
+
+    explicit FlatHashMap(size_t n) : FlatHashMap()
+    {
+        reserve(n);
+    }
+
+    //预留空间，保证插入n个元素之前不再扩容
+    void reserve(size_t n)
+    {
+        size_t slotNum = slotNumFor(n);
+        if(slotNum > ctrl.size())
+        {
+            rehash(slotNum);
+        }
+    }
+
+    iterator begin() { return iterator(this, 0, true); }
+    iterator end() { return iterator(this, ctrl.size()); }
+
+    size_t size() const { return elemNum; }
+    bool empty() const { return elemNum == 0; }
+
+    iterator find(const K& key)
+    {
+        return iterator(this, findIndex(key, hashOf(key)));
+    }
+    size_t count(const K& key) const
+    {
+        return findIndex(key, hashOf(key)) != ctrl.size() ? 1 : 0;
+    }
+    bool contains(const K& key) const
+    {
+        return findIndex(key, hashOf(key)) != ctrl.size();
+    }
+
+    //键不存在时插入，返回指向该键的迭代器以及是否插入成功
+    template <typename KK, typename... Args>
+    std::pair<iterator, bool> try_emplace(KK&& key, Args&&... args)
+    {
+        uint32_t hash = hashOf(key);
+        size_t index = findIndex(key, hash);
+        if(index != ctrl.size())
+        {
+            return {iterator(this, index), false};
+        }
+        prepareInsert();
+        index = findFreeIndex(hash);
+        if(ctrl[index] == CTRL_DELETED)--deleted;
+        ctrl[index] = h2Of(hash);
+        slots[index].kv.first = K(std::forward<KK>(key));
+        slots[index].kv.second = T(std::forward<Args>(args)...);
+        slots[index].hash = hash;
+        ++elemNum;
+        return {iterator(this, index), true};
+    }
+    template <typename KK, typename... Args>
+    std::pair<iterator, bool> emplace(KK&& key, Args&&... args)
+    {
+        return try_emplace(std::forward<KK>(key), std::forward<Args>(args)...);
+    }
+
+    T& operator[](const K& key)
+    {
+        return try_emplace(key).first->second;
+    }
+
+    size_t erase(const K& key)
+    {
+        size_t index = findIndex(key, hashOf(key));
+        if(index == ctrl.size())return 0;
+        eraseIndex(index);
+        return 1;
+    }
+    void erase(iterator it)
+    {
+        eraseIndex(it.index);
+    }
+
+    //清空全部键值对，保留已分配的槽位
+    void clear()
+    {
+        for(size_t i = 0; i < ctrl.size(); ++i)
+        {
+            if(ctrl[i] >= 0)slots[i].kv = value_type();
+            ctrl[i] = CTRL_EMPTY;
+        }
+        elemNum = 0;
+        deleted = 0;
+    }
+};
+
+}
+#endif //MYCACHE_FLATHASHMAP_H
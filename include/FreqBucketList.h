@@ -0,0 +1,184 @@
+#ifndef MYCACHE_FREQBUCKETLIST_H
+#define MYCACHE_FREQBUCKETLIST_H
+
+#include <cstddef>
+
+#include "SlabArena.h"
+
+namespace mycache {
+
+//频次桶：保存访问频次相同的全部节点，桶内按进入先后排列，队头最久
+template <typename Node>
+struct FreqBucket
+{
+    size_t freq;            //桶内节点共同的访问频次
+    size_t size;            //桶内节点数
+    Node* head;             //桶内最早进入的节点
+    Node* tail;             //桶内最晚进入的节点
+    FreqBucket* prev;       //频次更低的相邻桶
+    FreqBucket* next;       //频次更高的相邻桶
+
+    explicit FreqBucket(size_t f)
+    : freq(f)
+    , size(0)
+    , head(nullptr)
+    , tail(nullptr)
+    , prev(nullptr)
+    , next(nullptr) {}
+};
+
+//按频次升序串联的频次桶链表（O(1) LFU结构）
+//节点类型需要提供 Node* prev、Node* next 以及 FreqBucket<Node>* bucket 三个成员，
+//节点本身由使用者管理，桶从使用者的SlabArena中分配，空桶立即归还
+//访问频次加一、淘汰最小频次节点、查询最小频次都只涉及相邻的桶，均为常数时间
+//另外维护一个衰减游标，供使用者从低频到高频分批衰减频次：游标之前为已衰减的桶，游标及之后为未衰减的桶
+template <typename Node>
+class FreqBucketList
+{
+public:
+    using Bucket = FreqBucket<Node>;
+
+private:
+    SlabArena* arena;   //桶内存池
+    Bucket* first;      //频次最低的桶
+    Bucket* last;       //频次最高的桶
+    Bucket* cursor;     //衰减游标，指向第一个尚未衰减的桶，为空表示没有进行中的衰减
+
+private:
+    //在pos之后插入新桶，pos为空时插到最前
+    Bucket* insertBucketAfter(Bucket* pos, size_t freq)
+    {
+        Bucket* bucket = arena->create<Bucket>(freq);
+        bucket->prev = pos;
+        bucket->next = pos ? pos->next : first;
+        if(bucket->next)bucket->next->prev = bucket;
+        else last = bucket;
+        if(pos)pos->next = bucket;
+        else first = bucket;
+        return bucket;
+    }
+    //移除并释放空桶
+    void removeBucket(Bucket* bucket)
+    {
+        if(bucket->prev)bucket->prev->next = bucket->next;
+        else first = bucket->next;
+        if(bucket->next)bucket->next->prev = bucket->prev;
+        else last = bucket->prev;
+        if(cursor == bucket)cursor = bucket->next;
+        arena->destroy(bucket);
+    }
+    //将节点追加到桶尾
+    static void append(Bucket* bucket, Node* node)
+    {
+        node->bucket = bucket;
+        node->next = nullptr;
+        node->prev = bucket->tail;
+        if(bucket->tail)bucket->tail->next = node;
+        else bucket->head = node;
+        bucket->tail = node;
+        bucket->size++;
+    }
+    //将节点从所在桶中摘下，不释放桶
+    static void unlink(Node* node)
+    {
+        Bucket* bucket = node->bucket;
+        if(node->prev)node->prev->next = node->next;
+        else bucket->head = node->next;
+        if(node->next)node->next->prev = node->prev;
+        else bucket->tail = node->prev;
+        node->prev = nullptr;
+        node->next = nullptr;
+        bucket->size--;
+    }
+
+public:
+    explicit FreqBucketList(SlabArena* a) : arena(a), first(nullptr), last(nullptr), cursor(nullptr) {}
+    FreqBucketList(const FreqBucketList&) = delete;
+    FreqBucketList& operator=(const FreqBucketList&) = delete;
+    ~FreqBucketList()
+    {
+        clear();
+    }
+
+    bool empty() const { return first == nullptr; }
+    //最小访问频次，为空时返回0
+    size_t minFreq() const { return first ? first->freq : 0; }
+    //频次最低的桶
+    Bucket* firstBucket() const { return first; }
+    //淘汰候选：最小频次桶中最早进入的节点
+    Node* front() const { return first ? first->head : nullptr; }
+
+    //开始一轮衰减，游标指向频次最低的桶
+    void startAging() { cursor = first; }
+    //第一个尚未衰减的桶，为空表示本轮衰减已结束
+    Bucket* agingCursor() const { return cursor; }
+    //跳过游标所在的桶（该桶无需衰减）
+    void advanceAging() { if(cursor)cursor = cursor->next; }
+
+    //以指定频次加入新节点，频次需不大于当前最小频次（新节点通常为1）
+    void pushNew(Node* node, size_t freq = 1)
+    {
+        Bucket* bucket = first;
+        if(bucket == nullptr || bucket->freq != freq)
+        {
+            bucket = insertBucketAfter(nullptr, freq);
+        }
+        append(bucket, node);
+    }
+
+    //节点访问频次加一，移到相邻的高一级桶
+    void increment(Node* node)
+    {
+        Bucket* bucket = node->bucket;
+        Bucket* next = bucket->next;
+        if(next == nullptr || next->freq != bucket->freq + 1)
+        {
+            next = insertBucketAfter(bucket, bucket->freq + 1);
+        }
+        unlink(node);
+        append(next, node);
+        if(bucket->size == 0)removeBucket(bucket);
+    }
+
+    //将节点频次降到newFreq，放入紧挨当前桶之前的桶
+    //要求当前桶之前的桶频次都不大于newFreq：从低频到高频依次衰减，
+    //且衰减期间已衰减区域内的频次增长不越过newFreq时（由使用者保证）即满足
+    void moveDown(Node* node, size_t newFreq)
+    {
+        Bucket* bucket = node->bucket;
+        if(newFreq >= bucket->freq)return;
+        Bucket* target = bucket->prev;
+        if(target == nullptr || target->freq != newFreq)
+        {
+            target = insertBucketAfter(bucket->prev, newFreq);
+        }
+        unlink(node);
+        append(target, node);
+        if(bucket->size == 0)removeBucket(bucket);
+    }
+
+    //移除节点，节点本身由调用者释放
+    void remove(Node* node)
+    {
+        Bucket* bucket = node->bucket;
+        unlink(node);
+        node->bucket = nullptr;
+        if(bucket->size == 0)removeBucket(bucket);
+    }
+
+    //释放全部桶，节点本身由调用者释放
+    void clear()
+    {
+        while(first)
+        {
+            Bucket* next = first->next;
+            arena->destroy(first);
+            first = next;
+        }
+        last = nullptr;
+        cursor = nullptr;
+    }
+};
+
+}
+#endif //MYCACHE_FREQBUCKETLIST_H
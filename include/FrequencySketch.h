@@ -0,0 +1,119 @@
+#ifndef MYCACHE_FREQUENCYSKETCH_H
+#define MYCACHE_FREQUENCYSKETCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "HashUtil.h"
+
+namespace mycache {
+
+//4位计数的Count-Min频率草图，估计键最近的访问次数
+//  - 每个64位字存16个4位计数器，计数上限15；每个键由同一哈希派生出4个计数器，估计值取4个中的最小值
+//  - 计数器总数为容量向上取整到2的幂再乘16，平均每个缓存条目8字节，不保存键
+//  - 累计增加达到容量的10倍时所有计数器减半（周期衰减），过去的热点会逐渐冷却
+//与SlabArena一样只在所属缓存的锁内使用，内部不加锁
+template <typename K>
+class FrequencySketch
+{
+private:
+    static constexpr uint64_t RESET_MASK = 0x7777777777777777ULL;     //减半时清除每个计数器右移进来的高位
+
+    std::vector<uint64_t> table;    //计数器表，每个字16个计数器
+    size_t counterMask;             //计数器下标掩码，计数器总数为2的幂
+    size_t sampleSize;              //两次减半之间的累计增加次数
+    size_t additions;               //自上次减半以来的累计增加次数
+
+private:
+    //由键的哈希值派生第i个计数器的下标：高低32位做双重哈希
+    size_t indexOf(uint64_t h, uint32_t i) const
+    {
+        uint64_t step = (h >> 32) | 1;
+        return static_cast<size_t>(h + i * step) & counterMask;
+    }
+    static uint64_t hashOf(const K& key)
+    {
+        return hashMix(static_cast<uint64_t>(std::hash<K>()(key)));
+    }
+    //所有计数器减半，累计次数同样减半
+    void halve()
+    {
+        for(uint64_t& word : table)
+        {
+            word = (word >> 1) & RESET_MASK;
+        }
+        additions /= 2;
+    }
+
+public:
+    //capacity：所属缓存的容量，决定计数器数量与衰减周期
+    explicit FrequencySketch(size_t capacity = 0)
+    {
+        resize(capacity);
+    }
+
+    //按新容量重建并清空草图
+    void resize(size_t capacity)
+    {
+        size_t words = 8;
+        while(words < capacity)words <<= 1;
+        table.assign(words, 0);
+        counterMask = words * 16 - 1;
+        sampleSize = (capacity > 0 ? capacity : 1) * 10;
+        additions = 0;
+    }
+
+    //记录一次访问：4个计数器中等于最小值的才加1（保守更新），减少哈希冲突造成的高估
+    void increment(const K& key)
+    {
+        uint64_t h = hashOf(key);
+        uint32_t minCount = 15;
+        size_t index[4];
+        for(uint32_t i = 0; i < 4; ++i)
+        {
+            index[i] = indexOf(h, i);
+            uint32_t count = static_cast<uint32_t>(table[index[i] >> 4] >> ((index[i] & 15) * 4)) & 0xf;
+            if(count < minCount)minCount = count;
+        }
+        if(minCount == 15)return;
+        for(uint32_t i = 0; i < 4; ++i)
+        {
+            uint32_t shift = static_cast<uint32_t>(index[i] & 15) * 4;
+            uint64_t& word = table[index[i] >> 4];
+            if(((word >> shift) & 0xf) == minCount)word += uint64_t(1) << shift;
+        }
+        if(++additions >= sampleSize)halve();
+    }
+
+    //估计键的访问次数，0到15
+    uint32_t frequency(const K& key) const
+    {
+        uint64_t h = hashOf(key);
+        uint32_t minCount = 15;
+        for(uint32_t i = 0; i < 4; ++i)
+        {
+            size_t index = indexOf(h, i);
+            uint32_t count = static_cast<uint32_t>(table[index >> 4] >> ((index & 15) * 4)) & 0xf;
+            if(count < minCount)minCount = count;
+        }
+        return minCount;
+    }
+
+    //清零全部计数器
+    void clear()
+    {
+        for(uint64_t& word : table)
+        {
+            word = 0;
+        }
+        additions = 0;
+    }
+
+    //草图占用的字节数
+    size_t bytes() const { return table.size() * sizeof(uint64_t); }
+};
+
+}
+#endif //MYCACHE_FREQUENCYSKETCH_H
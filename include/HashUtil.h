@@ -0,0 +1,23 @@
+#ifndef MYCACHE_HASHUTIL_H
+#define MYCACHE_HASHUTIL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mycache {
+
+//对std::hash的结果做二次混合
+//std::hash对整数是恒等映射，连续的键直接取低位会集中在相邻的桶（或分片）里，
+//经过混合后每一位都依赖键的全部位，低位和高位都可以直接拿来用
+inline uint64_t hashMix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+}
+#endif //MYCACHE_HASHUTIL_H
@@ -3,143 +3,162 @@
 
 #include <cmath>
 #include <memory>
-#include <unordered_map>
 #include <thread>
 #include <mutex>
+#include <utility>
 
 #include "CachePolicy.h"
+#include "CacheWeigher.h"
+#include "SlabArena.h"
+#include "FlatHashMap.h"
+#include "ShardedCache.h"
+#include "FreqBucketList.h"
+#include "WriteBehind.h"
 
 namespace mycache {
 
-template <typename K, typename V> class LfuCache;
+//LFU频次衰减策略
+enum class LfuDecay
+{
+    None,       //不衰减
+    Subtract,   //频次减去最大平均访问频次的一半（最小为1）
+    Halve       //频次减半（最小为1）
+};
 
+//LFU缓存节点，挂在所属频次桶的链表中，访问频次即所在桶的频次
 template <typename K, typename V> 
-class freqList
+struct LfuNode
 {
-private:
-    struct Node
-    {
-        K key;
-        V value;
-        int freq;                    //标识每个双向链表中节点的访问频次
-        bool dirty;                  //标识节点是否脏数据
-        std::shared_ptr<Node> prev;
-        std::shared_ptr<Node> next;
-        Node() : freq(1),  prev(nullptr), next(nullptr),dirty(false) {}
-        Node(const K& k, const V& v) : key(k), value(v), freq(1), prev(nullptr), next(nullptr) ,dirty(false){}
-    };
-
-    using NodePtr = std::shared_ptr<Node>;
-    NodePtr head;   //虚拟头结点
-    NodePtr tail;   //虚拟尾结点
-    int freq;       //标识当前双向链表中节点的共同访问频次
-
-public:
-    //构造函数
-    explicit freqList(int n) : freq(n)
-    {
-        head = std::make_shared<Node>();
-        tail = std::make_shared<Node>();
-        head->next = tail;
-        tail->prev = head;
-    }
-    //判断链表是否为空
-    bool isEmpty()const
-    {
-        return head->next == tail;
-    }
-    //添加节点到链表尾部
-    void addNode(NodePtr node)
-    {
-        if(!node||!head||!tail)return;
-        node->next = tail;
-        node->prev = tail->prev;
-        tail->prev->next = node;
-        tail->prev = node;
-    }
-    //移除链表中的节点
-    void removeNode(NodePtr node)
-    {
-        if(!node||!head||!tail)return;
-        if(!node->prev||!node->next)return;
-        node->prev->next = node->next;
-        node->next->prev = node->prev;
-        node->prev = nullptr;
-        node->next = nullptr;
-    }
-    //获取链表中的第一个节点
-    NodePtr getFirstNode()const
-    {
-        return head->next;
-    }
-
-    friend class LfuCache<K, V>;
+    K key;
+    V value;
+    bool dirty;                         //写入后尚未写回存储
+    LfuNode* prev;
+    LfuNode* next;
+    FreqBucket<LfuNode>* bucket;        //所属频次桶
+    //键和值的构造参数直接转发，值在节点中原地构造
+    template <typename KK, typename... Args>
+    explicit LfuNode(KK&& k, Args&&... args)
+    : key(std::forward<KK>(k)), value(std::forward<Args>(args)...), dirty(false), prev(nullptr), next(nullptr), bucket(nullptr) {}
+
+    size_t freq() const { return bucket->freq; }
 };
 
 template <typename K, typename V> 
 class LfuCache : public CachePolicy<K, V>
 {
 public:
-    using LfuNodeType = typename freqList<K, V>::Node;
-    using LfuNodePtr = std::shared_ptr<LfuNodeType>;
-    using LfuNodeMap = std::unordered_map<K, LfuNodePtr>;
-    using LfufreqMap = std::unordered_map<int, freqList<K, V>*>;
+    using LfuNodeType = LfuNode<K, V>;
+    using LfuNodePtr = LfuNodeType*;
+    using LfuNodeMap = FlatHashMap<K, LfuNodePtr>;
+    using LfuFreqList = FreqBucketList<LfuNodeType>;
+    using Weigher = typename CacheWeight<K, V>::Weigher;
 private:
     size_t capacity;                                        //缓存容量
-    int minFreq;                                            //最小访问缓存频次
-    int maxAverageNum;                                      //最大平均访问缓存频次数
-    int curAverageNum;                                      //当前平均访问缓存频次数
-    int curTotalNum;                                        //当前访问缓存频次总数
-    std::mutex mtx;                                        //互斥锁
+    size_t maxAverageNum;                                   //最大平均访问缓存频次数
+    size_t curAverageNum;                                   //当前平均访问缓存频次数
+    size_t curTotalNum;                                     //当前访问缓存频次总数
+    LfuDecay decayPolicy;                                   //频次衰减策略
+    size_t agingStep;                                       //每次访问最多衰减的节点数
+    std::mutex mtx;                                         //互斥锁
+    SlabArena arena;                                        //节点与频次桶内存池
     LfuNodeMap nodeMap;                                     //节点哈希表，快速访问节点
-    LfufreqMap freqListMap;                                 //访问频次哈希表，快速访问频次对应的双向链表
+    LfuFreqList freqList;                                   //按频次升序排列的频次桶链表，表头即最小频次
+    CacheWeight<K, V> weight;                               //按权重限制容量时的记账
+    std::shared_ptr<WriteBehindQueue<K, V>> writeBack;      //脏数据写回队列，为空时淘汰直接丢弃数据
 
 private:
-    //添加缓存
-    void putInternal(const K& key, const V& value);
-    //获取缓存
-    void getInternal(LfuNodePtr node, V& value);
-    //移除频次链表中的节点
-    void removeFromFreqList(LfuNodePtr node);
-    //添加节点到频次链表中
-    void addToFreqList(LfuNodePtr node);
+    //添加或更新缓存，调用者已持有锁
+    template <typename KK, typename... Args>
+    void putLocked(KK&& key, Args&&... args);
+    //更新已有节点的值并增加访问频次，调用者已持有锁
+    template <typename... Args>
+    void updateNode(LfuNodePtr node, Args&&... args);
+    //读-改-写缓存，调用者已持有锁：fn以旧值的指针（不存在时为nullptr）计算新值，写入并返回新值
+    template <typename F>
+    V computeLocked(const K& key, F&& fn);
+    //获取缓存，调用者已持有锁
+    bool getLocked(const K& key, V& value);
+    //添加缓存，返回新节点
+    template <typename KK, typename... Args>
+    LfuNodePtr putInternal(KK&& key, Args&&... args);
+    //访问节点，更新访问频次
+    void getInternal(LfuNodePtr node);
     //增加平均访问频次
     void addFreqNum();
     //减少平均访问频次
-    void decreaseFreqNum(int num);
-    //更新最小访问频次
-    void updateMinFreq();
+    void decreaseFreqNum(size_t num);
+    //重新计算平均访问频次
+    void updateAverageNum();
     //处理超过最大平均访问频次的情况
     void HandleOverMaxAverageNum();
+    //计算频次衰减后的值
+    size_t decayFreq(size_t freq) const;
+    //推进进行中的衰减，最多处理agingStep个节点
+    void ageSome();
     //淘汰缓存中的过期数据
     void kickOut();
+    //总权重超过上限时继续淘汰，新写入的数据在同频次中最后被淘汰
+    void trimToWeight();
+    //把缓存中的全部脏数据复制到写回队列并标记为干净
+    void writeBackAll();
+    //释放全部节点与频次桶
+    void destroyAll();
 
 public:
-    LfuCache(size_t n, int maxAveNum = 10) 
+    //maxAveNum：平均访问频次超过该值时开始一轮衰减
+    //decay：衰减策略；step：每次访问最多衰减的节点数，衰减分摊到后续的访问中完成
+    LfuCache(size_t n, int maxAveNum = 10, LfuDecay decay = LfuDecay::Subtract, size_t step = 8) 
     : capacity(n)
-    , minFreq(0)
-    , maxAverageNum(maxAveNum)
+    , maxAverageNum(maxAveNum > 0 ? maxAveNum : 1)
     , curAverageNum(0)
-    , curTotalNum(0){}
+    , curTotalNum(0)
+    , decayPolicy(decay)
+    , agingStep(step > 0 ? step : 1)
+    , freqList(&arena)
+    {
+        nodeMap.reserve(capacity);
+    }
 
-    ~LfuCache() override = default;
+    //析构时把未写回的脏数据交给写回队列
+    ~LfuCache() override
+    {
+        writeBackAll();
+        destroyAll();
+    }
     //向缓存中添加或更新键值对
     void put(const K& key, const V& value) override
     {
         if(capacity <= 0)return;
 
-        std::lock_guard<std::mutex> lock(mtx);
-        auto it = nodeMap.find(key);
-        if(it != nodeMap.end())
-        {
-            //更新节点的值
-            LfuNodePtr node = it->second;
-            node->value = value;
-            //更新节点的访问频次
-            getInternal(node, node->value);
-            return;
-        }
-        putInternal(key, value);
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        putLocked(key, value);
+    }
+    //右值版本，键和值移动到节点中
+    void put(K&& key, V&& value) override
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        putLocked(std::move(key), std::move(value));
+    }
+    //写入从存储加载的数据：键不存在时插入且不标记为脏，已存在时保留缓存中的值
+    void putLoaded(const K& key, const V& value) override
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        if(nodeMap.contains(key))return;
+        putInternal(key, value)->dirty = false;
+        trimToWeight();
+    }
+    //原地构造缓存数据：args直接用于构造值，键已存在时以新构造的值替换旧值
+    template <typename KK, typename... Args>
+    void emplace(KK&& key, Args&&... args)
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        putLocked(std::forward<KK>(key), std::forward<Args>(args)...);
     }
     //根据键获取值，并更新该节点为最近使用的节点，访问成功返回true，否则返回false
     bool get(const K& key, V& value)override
@@ -147,17 +166,7 @@ public:
         if(capacity <= 0)return false;
 
         std::lock_guard<std::mutex> lock(mtx);
-        
-        auto it = nodeMap.find(key);
-        if(it != nodeMap.end())
-        {
-            LfuNodePtr node = it->second;
-            value = node->value;
-            //更新节点的访问频次
-            getInternal(node, value);
-            return true;
-        }
-        return false;
+        return getLocked(key, value);
     }
     //重载的 get 方法，直接返回值
     V get(const K& key)override
@@ -166,189 +175,368 @@ public:
         get(key, value);
         return value;
     }
+    //原地访问缓存值：命中时在持锁期间以const V&调用fn，不拷贝值，并与get一样更新访问频次
+    //fn返回后引用即失效，fn内不能再访问同一个缓存
+    template <typename F>
+    bool visit(const K& key, F&& fn)
+    {
+        if(capacity <= 0)return false;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end())return false;
+        LfuNodePtr node = it->second;
+        fn(static_cast<const V&>(node->value));
+        getInternal(node);
+        return true;
+    }
+    //原子地读-改-写：fn(const V* old)返回新值，键不存在时old为nullptr，新值写入缓存并返回
+    //查找、计算与写入在同一次加锁内完成；fn在持锁期间调用，fn内不能再访问同一个缓存
+    template <typename F>
+    V compute(const K& key, F&& fn)
+    {
+        if(capacity <= 0)return fn(static_cast<const V*>(nullptr));
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        return computeLocked(key, std::forward<F>(fn));
+    }
+    //键存在时以fn(const V& old)的返回值替换旧值，不存在时不写入，返回键是否存在
+    template <typename F>
+    bool computeIfPresent(const K& key, F&& fn)
+    {
+        if(capacity <= 0)return false;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end())return false;
+        LfuNodePtr node = it->second;
+        updateNode(node, fn(static_cast<const V&>(node->value)));
+        trimToWeight();
+        return true;
+    }
+    //合并写入：键不存在时写入value，存在时写入fn(old, value)，返回写入的新值，适合计数器与聚合值
+    template <typename F>
+    V merge(const K& key, const V& value, F&& fn)
+    {
+        return compute(key, [&](const V* old) -> V { return old ? fn(*old, value) : value; });
+    }
+    //批量获取，整批只加一次锁
+    size_t getBatch(const K* keys, const size_t* order, size_t n, V* values, uint64_t* hitBits)override
+    {
+        if(capacity <= 0)return 0;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t hits = 0;
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            if(getLocked(keys[i], values[i]))
+            {
+                hitBits[i / 64] |= uint64_t(1) << (i % 64);
+                ++hits;
+            }
+        }
+        return hits;
+    }
+    //批量添加或更新，整批只加一次锁
+    void putBatch(const K* keys, const V* values, const size_t* order, size_t n)override
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            putLocked(keys[i], values[i]);
+        }
+    }
     //清空缓存
     void purge()
     {
-        nodeMap.clear();
-        freqListMap.clear();
+        std::lock_guard<std::mutex> lock(mtx);
+        destroyAll();
+        curAverageNum = 0;
+        curTotalNum = 0;
+    }
+    //设置权重上限（字节数），0表示只按条目数限制；超出上限时立即淘汰
+    //两种限制同时生效：条目数达到容量或总权重超过上限都会触发淘汰
+    void setMaxWeight(size_t maxWeight)
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        weight.setMaxWeight(maxWeight);
+        trimToWeight();
+    }
+    //设置权重函数，已缓存的数据按新函数重新计算总权重
+    void setWeigher(Weigher weigher)
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        weight.setWeigher(std::move(weigher));
+        weight.reset();
+        for(auto it = nodeMap.begin(); it != nodeMap.end(); ++it)
+        {
+            weight.add(weight.weigh(it->first, it->second->value));
+        }
+        trimToWeight();
+    }
+    //当前总权重
+    size_t totalWeight()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return weight.total();
+    }
+    //开启写回：写入的数据标记为脏，脏数据被淘汰时放入写回队列，由队列的后台线程批量写回存储
+    //purge删除的数据不写回；传入空指针关闭写回
+    void setWriteBack(std::shared_ptr<WriteBehindQueue<K, V>> queue)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        writeBack = std::move(queue);
+    }
+    //把缓存中的脏数据全部交给写回队列，并阻塞到队列写回完成；数据仍保留在缓存中
+    void flush()
+    {
+        std::shared_ptr<WriteBehindQueue<K, V>> queue;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            writeBackAll();
+            queue = writeBack;
+        }
+        if(queue)queue->flush();
     }
 };
 
 template <typename K, typename V>
-void LfuCache<K, V>::putInternal(const K &key, const V &value)
+template <typename KK, typename... Args>
+void LfuCache<K, V>::putLocked(KK &&key, Args &&...args)
 {
-    if(nodeMap.size()==capacity)
+    auto it = nodeMap.find(key);
+    if(it != nodeMap.end())
     {
-        //淘汰缓存中的过期数据
-        kickOut();
+        updateNode(it->second, std::forward<Args>(args)...);
     }
-    LfuNodePtr node = std::make_shared<LfuNodeType>(key, value);
-    nodeMap[key] = node;
-    addToFreqList(node);
-    addFreqNum();
-    minFreq = 1;
+    else
+    {
+        putInternal(std::forward<KK>(key), std::forward<Args>(args)...);
+    }
+    trimToWeight();
+}
+
+template <typename K, typename V>
+template <typename... Args>
+void LfuCache<K, V>::updateNode(LfuNodePtr node, Args &&...args)
+{
+    //更新节点的值
+    weight.sub(weight.weigh(node->key, node->value));
+    node->value = V(std::forward<Args>(args)...);
+    weight.add(weight.weigh(node->key, node->value));
+    node->dirty = true;
+    //更新节点的访问频次
+    getInternal(node);
 }
 
 template <typename K, typename V>
-void LfuCache<K, V>::getInternal(LfuNodePtr node, V &value)
+template <typename F>
+V LfuCache<K, V>::computeLocked(const K &key, F &&fn)
 {
-    value = node->value;
-    removeFromFreqList(node);
-    node->freq++;
-    addToFreqList(node);
-    if(node->freq-1 == minFreq && freqListMap[minFreq]->isEmpty())
+    V value;
+    auto it = nodeMap.find(key);
+    if(it != nodeMap.end())
     {
-        minFreq++;
+        LfuNodePtr node = it->second;
+        updateNode(node, fn(static_cast<const V*>(&node->value)));
+        value = node->value;
     }
-    addFreqNum();
+    else
+    {
+        value = fn(static_cast<const V*>(nullptr));
+        putInternal(key, value);
+    }
+    trimToWeight();
+    return value;
 }
 
 template <typename K, typename V>
-void LfuCache<K, V>::removeFromFreqList(LfuNodePtr node)
+bool LfuCache<K, V>::getLocked(const K &key, V &value)
 {
-    if(!node)return;
+    auto it = nodeMap.find(key);
+    if(it != nodeMap.end())
+    {
+        value = it->second->value;
+        //更新节点的访问频次
+        getInternal(it->second);
+        return true;
+    }
+    return false;
+}
 
-    auto freq = node->freq;
-    freqListMap[freq]->removeNode(node);
+template <typename K, typename V>
+template <typename KK, typename... Args>
+typename LfuCache<K, V>::LfuNodePtr LfuCache<K, V>::putInternal(KK &&key, Args &&...args)
+{
+    if(nodeMap.size() >= capacity)
+    {
+        //淘汰缓存中的过期数据
+        kickOut();
+    }
+    LfuNodePtr node = arena.create<LfuNodeType>(std::forward<KK>(key), std::forward<Args>(args)...);
+    node->dirty = true;
+    nodeMap.emplace(node->key, node);
+    weight.add(weight.weigh(node->key, node->value));
+    freqList.pushNew(node);
+    addFreqNum();
+    ageSome();
+    return node;
 }
 
 template <typename K, typename V>
-void LfuCache<K, V>::addToFreqList(LfuNodePtr node)
+void LfuCache<K, V>::getInternal(LfuNodePtr node)
 {
-    if(!node)return;
-    auto freq = node->freq;
-    if(freqListMap.find(freq) == freqListMap.end())
+    //衰减进行中时，已衰减区域的频次不能越过游标处的桶衰减后的频次，否则会破坏频次桶的升序
+    auto cursor = freqList.agingCursor();
+    if(cursor != nullptr && node->bucket->next == cursor && node->freq() + 1 > decayFreq(cursor->freq))
     {
-        freqListMap[freq] = new freqList<K, V>(freq);
+        ageSome();
+        return;
     }
-    freqListMap[freq]->addNode(node);
+    freqList.increment(node);
+    addFreqNum();
+    ageSome();
 }
 
 template <typename K, typename V>
 void LfuCache<K, V>::addFreqNum()
 {
     curTotalNum++;
+    updateAverageNum();
 
-    if(nodeMap.empty())
-    {
-        curAverageNum = 0;
-    }
-    else 
-    {
-        curAverageNum = std::ceil(curTotalNum / nodeMap.size());
-    }
-
-    if(curTotalNum > maxAverageNum)
+    if(curAverageNum > maxAverageNum)
     {
         HandleOverMaxAverageNum();
     }
 }
 
 template <typename K, typename V>
-void LfuCache<K, V>::decreaseFreqNum(int num)
+void LfuCache<K, V>::decreaseFreqNum(size_t num)
 {
     curTotalNum -= num;
+    updateAverageNum();
+}
 
+template <typename K, typename V>
+void LfuCache<K, V>::updateAverageNum()
+{
     if(nodeMap.empty())
     {
         curAverageNum = 0;
     }
     else 
     {
-        curAverageNum = std::ceil(curTotalNum / nodeMap.size());
+        curAverageNum = (curTotalNum + nodeMap.size() - 1) / nodeMap.size();
     }
 }
 
 template <typename K, typename V>
-void LfuCache<K, V>::updateMinFreq()
+void LfuCache<K, V>::HandleOverMaxAverageNum()
 {
-    if(nodeMap.empty())
-    {
-        minFreq = 0;
-    }
-    else
+    //已有一轮衰减在进行时不重复开始，衰减本身由ageSome分批完成
+    if(decayPolicy == LfuDecay::None || freqList.agingCursor() != nullptr)return;
+    freqList.startAging();
+}
+
+template <typename K, typename V>
+size_t LfuCache<K, V>::decayFreq(size_t freq) const
+{
+    switch(decayPolicy)
     {
-        minFreq = nodeMap.begin()->second->freq;
-        for(auto it = nodeMap.begin(); it != nodeMap.end(); ++it)
-        {
-            if(it->second->freq < minFreq)
-            {
-                minFreq = it->second->freq;
-            }
-        }
+    case LfuDecay::Subtract:
+        return freq > maxAverageNum / 2 + 1 ? freq - maxAverageNum / 2 : 1;
+    case LfuDecay::Halve:
+        return freq > 1 ? freq / 2 : 1;
+    default:
+        return freq;
     }
 }
 
 template <typename K, typename V>
-void LfuCache<K, V>::HandleOverMaxAverageNum()
+void LfuCache<K, V>::ageSome()
 {
-    if(nodeMap.empty())return;
-
-    for(auto it = nodeMap.begin(); it != nodeMap.end(); ++it)
+    if(freqList.agingCursor() == nullptr)return;
+    //从低频桶到高频桶依次衰减，已衰减的桶总排在游标之前，频次仍保持升序
+    for(size_t step = 0; step < agingStep; ++step)
     {
-        if(it->second)continue;
-
-        LfuNodePtr node = it->second;
-        removeFromFreqList(node);
-        node->freq -= maxAverageNum/2;
-        addToFreqList(node);
+        auto bucket = freqList.agingCursor();
+        if(bucket == nullptr)break;
+        size_t newFreq = decayFreq(bucket->freq);
+        if(newFreq >= bucket->freq)
+        {
+            freqList.advanceAging();
+            continue;
+        }
+        //桶内最后一个节点移走后桶被释放，游标自动指向下一个桶
+        curTotalNum -= bucket->freq - newFreq;
+        freqList.moveDown(bucket->head, newFreq);
     }
-    updateMinFreq();
+    updateAverageNum();
 }
 
 template <typename K, typename V>
 void LfuCache<K, V>::kickOut()
 {
-    LfuNodePtr node = freqListMap[minFreq]->getFirstNode();
-    removeFromFreqList(node);
+    LfuNodePtr node = freqList.front();
+    if(node == nullptr)return;
+    size_t freq = node->freq();
+    freqList.remove(node);
     nodeMap.erase(node->key);
-    decreaseFreqNum(node->freq);
+    weight.sub(weight.weigh(node->key, node->value));
+    decreaseFreqNum(freq);
+    if(writeBack && node->dirty)
+    {
+        writeBack->enqueue(std::move(node->key), std::move(node->value));
+    }
+    arena.destroy(node);
 }
 
 template <typename K, typename V>
-class HashLfuCache : public CachePolicy<K, V>
+void LfuCache<K, V>::trimToWeight()
 {
-private:
-    size_t capacity;                                            //缓存容量
-    int sliceNum;                                               //切片数量
-    std::vector<std::unique_ptr<LfuCache<K,V>>> sliceCaches;    //切片缓存
-
-private:
-    size_t Hash(const K& key)
+    while(weight.overLimit() && !nodeMap.empty())
     {
-        std::hash<K> hashFunc;
-        return hashFunc(key);
+        kickOut();
     }
+}
 
-public:
-    HashLfuCache(size_t n, int sliceNum_) : capacity(n), sliceNum(sliceNum_)
+template <typename K, typename V>
+void LfuCache<K, V>::writeBackAll()
+{
+    if(!writeBack)return;
+    for(auto it = nodeMap.begin(); it != nodeMap.end(); ++it)
     {
-        sliceCaches.resize(sliceNum);
-        size_t sliceSize =ceil(capacity / static_cast<double>(sliceNum));
-        for (int i = 0; i < sliceNum; ++i)
-        {
-            sliceCaches[i] = std::make_unique<LfuCache<K,V>>(sliceSize);
-        }
+        LfuNodePtr node = it->second;
+        if(!node->dirty)continue;
+        writeBack->enqueue(node->key, node->value);
+        node->dirty = false;
     }
+}
 
-    void put(const K& key, const V& value)
+template <typename K, typename V>
+void LfuCache<K, V>::destroyAll()
+{
+    for(auto it = nodeMap.begin(); it != nodeMap.end(); ++it)
     {
-        int sliceIndex = Hash(key) % sliceNum;
-        sliceCaches[sliceIndex]->put(key, value);
-    }
-
-    bool get(const K& key, V& value)
-    {  
-        int sliceIndex = Hash(key) % sliceNum;
-        return sliceCaches[sliceIndex]->get(key, value);
+        arena.destroy(it->second);
     }
+    nodeMap.clear();
+    freqList.clear();
+    weight.reset();
+}
 
-    V get(const K& key)
-    {
-        V value{};
-        get(key, value);
-        return value;
-    }
+//按键的哈希值分片的LFU缓存，各切片独立加锁，分片逻辑见ShardedCache
+template <typename K, typename V>
+class HashLfuCache : public ShardedCache<LfuCache<K, V>>
+{
+public:
+    //n：总容量；sliceNum：切片数量，向上取整为2的幂
+    HashLfuCache(size_t n, int sliceNum)
+    : ShardedCache<LfuCache<K, V>>(n, sliceNum > 0 ? static_cast<size_t>(sliceNum) : 1) {}
 };
 
 }
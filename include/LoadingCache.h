@@ -0,0 +1,343 @@
+#ifndef MYCACHE_LOADINGCACHE_H
+#define MYCACHE_LOADINGCACHE_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "BackingStore.h"
+#include "CachePolicy.h"
+#include "HashUtil.h"
+#include "SingleFlight.h"
+#include "WriteBehind.h"
+
+namespace mycache {
+
+//架在任意CachePolicy与BackingStore之间的旁路加载层
+//  - 读穿透：get未命中时从存储加载并写入缓存，同一个键的并发未命中只加载一次
+//  - 写穿透：put先写存储再写缓存，同一个键的两步在键锁内完成，并发写入同一个键时缓存与存储保留同一次写入的值；setWriteBehind(queue)后改为只写缓存，由缓存淘汰时经队列异步写回
+//  - 预取：prefetch(keys)把一组键交给后台工作线程，按批loadMany后写入缓存，调用者不等待
+//加载的数据通过putLoaded写入：键已在缓存中时保留缓存中较新的值，且不标记为脏，不会被写回
+template <typename K, typename V>
+class LoadingCache
+{
+private:
+    //一次加载的结果，存储中没有该键时found为false
+    struct Loaded
+    {
+        bool found = false;
+        V value{};
+    };
+
+    static constexpr size_t PREFETCH_BATCH = 64;       //预取时每次loadMany的最大键数
+    static constexpr size_t WRITE_STRIPES = 64;        //写穿透的键锁段数，putMany用一个64位掩码记录要加的锁
+
+    //写穿透的键锁，按缓存行对齐
+    struct alignas(64) WriteStripe
+    {
+        std::mutex mtx;
+    };
+
+    //按掩码从小到大依次锁住多个段，析构时全部释放；多个putMany按同一顺序加锁，不会互相等待成环
+    class StripeLocks
+    {
+    private:
+        WriteStripe* stripes;
+        uint64_t mask;
+    public:
+        StripeLocks(WriteStripe* all, uint64_t lockMask)
+        : stripes(all)
+        , mask(0)
+        {
+            for(size_t i = 0; i < WRITE_STRIPES; ++i)
+            {
+                if(!(lockMask >> i & 1))continue;
+                stripes[i].mtx.lock();
+                mask |= uint64_t(1) << i;
+            }
+        }
+        ~StripeLocks()
+        {
+            for(size_t i = 0; i < WRITE_STRIPES; ++i)
+            {
+                if(mask >> i & 1)stripes[i].mtx.unlock();
+            }
+        }
+        StripeLocks(const StripeLocks&) = delete;
+        StripeLocks& operator=(const StripeLocks&) = delete;
+    };
+
+    CachePolicy<K, V>& cache;
+    std::shared_ptr<BackingStore<K, V>> store;
+    std::shared_ptr<WriteBehindQueue<K, V>> writeBehind;   //为空时写穿透
+    SingleFlight<K, Loaded> loadGroup;                      //合并同一个键的并发加载
+    WriteStripe writeStripes[WRITE_STRIPES];                //写穿透时按键哈希选择的键锁
+
+    std::mutex taskMtx;
+    std::condition_variable taskReady;      //通知工作线程有预取任务
+    std::condition_variable idle;           //通知waitIdle调用者任务全部完成
+    std::deque<std::vector<K>> tasks;       //待执行的预取任务，每个任务最多PREFETCH_BATCH个键
+    size_t busyNum;                         //正在执行任务的工作线程数
+    bool stopping;
+    std::vector<std::thread> workers;
+
+    std::atomic<size_t> loadNum;            //从存储加载到的条数
+    std::atomic<size_t> prefetchNum;        //预取写入缓存的条数
+    std::atomic<size_t> prefetchFailedNum;  //加载抛出异常而放弃预取的条数
+
+private:
+    //键所在的键锁段，取混合后64位哈希的高6位
+    static size_t writeStripeOf(const K& key)
+    {
+        return static_cast<size_t>(hashMix(static_cast<uint64_t>(std::hash<K>()(key))) >> 58);
+    }
+
+    //从存储加载一个键，开启异步写回时尚未写回的数据比存储中的新
+    bool loadOne(const K& key, V& value)
+    {
+        if(writeBehind && writeBehind->find(key, value))return true;
+        if(!store->load(key, value))return false;
+        loadNum.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    //批量加载order给出的n个下标对应的键，加载到的值写入缓存并置位foundBits，返回加载到的个数
+    size_t loadBatch(const K* keys, const size_t* order, size_t n, V* values, uint64_t* foundBits)
+    {
+        std::vector<K> missKeys;
+        std::vector<size_t> missOrder;
+        missKeys.reserve(n);
+        missOrder.reserve(n);
+        size_t found = 0;
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order[j];
+            if(writeBehind && writeBehind->find(keys[i], values[i]))
+            {
+                cache.putLoaded(keys[i], values[i]);
+                foundBits[i / 64] |= uint64_t(1) << (i % 64);
+                ++found;
+                continue;
+            }
+            missKeys.push_back(keys[i]);
+            missOrder.push_back(i);
+        }
+        if(missKeys.empty())return found;
+
+        std::vector<V> loaded(missKeys.size());
+        std::vector<uint64_t> loadedBits((missKeys.size() + 63) / 64);
+        size_t loadedNum = store->loadMany(missKeys.data(), missKeys.size(), loaded.data(), loadedBits.data());
+        loadNum.fetch_add(loadedNum, std::memory_order_relaxed);
+        for(size_t j = 0; j < missKeys.size(); ++j)
+        {
+            if(!(loadedBits[j / 64] >> (j % 64) & 1))continue;
+            size_t i = missOrder[j];
+            cache.putLoaded(missKeys[j], loaded[j]);
+            values[i] = std::move(loaded[j]);
+            foundBits[i / 64] |= uint64_t(1) << (i % 64);
+        }
+        return found + loadedNum;
+    }
+
+    //工作线程：取出预取任务，跳过已在缓存中的键，其余按批加载
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(taskMtx);
+        while(true)
+        {
+            taskReady.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if(tasks.empty())break;
+            std::vector<K> keys = std::move(tasks.front());
+            tasks.pop_front();
+            ++busyNum;
+            lock.unlock();
+
+            size_t n = keys.size();
+            std::vector<V> values(n);
+            std::vector<uint64_t> bits((n + 63) / 64);
+            cache.getMany(keys.data(), n, values.data(), bits.data());
+            std::vector<size_t> order;
+            order.reserve(n);
+            for(size_t i = 0; i < n; ++i)
+            {
+                if(!(bits[i / 64] >> (i % 64) & 1))order.push_back(i);
+            }
+            try
+            {
+                if(!order.empty())
+                {
+                    size_t hits = loadBatch(keys.data(), order.data(), order.size(), values.data(), bits.data());
+                    prefetchNum.fetch_add(hits, std::memory_order_relaxed);
+                }
+            }
+            catch(...)
+            {
+                prefetchFailedNum.fetch_add(order.size(), std::memory_order_relaxed);
+            }
+
+            lock.lock();
+            --busyNum;
+            if(tasks.empty() && busyNum == 0)idle.notify_all();
+        }
+    }
+
+public:
+    //cache：被加载的缓存，生命周期需长于本对象；store：持久存储；workerNum：预取工作线程数，至少为1
+    LoadingCache(CachePolicy<K, V>& target, std::shared_ptr<BackingStore<K, V>> backingStore, size_t workerNum = 2)
+    : cache(target)
+    , store(std::move(backingStore))
+    , busyNum(0)
+    , stopping(false)
+    , loadNum(0)
+    , prefetchNum(0)
+    , prefetchFailedNum(0)
+    {
+        workerNum = std::max<size_t>(workerNum, 1);
+        workers.reserve(workerNum);
+        for(size_t i = 0; i < workerNum; ++i)
+        {
+            workers.emplace_back([this] { run(); });
+        }
+    }
+
+    LoadingCache(const LoadingCache&) = delete;
+    LoadingCache& operator=(const LoadingCache&) = delete;
+
+    //执行完已提交的预取任务后停止工作线程
+    ~LoadingCache()
+    {
+        {
+            std::lock_guard<std::mutex> lock(taskMtx);
+            stopping = true;
+        }
+        taskReady.notify_all();
+        for(auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    //切换为异步写回：put只写缓存，加载时先查队列中尚未写回的数据
+    //缓存需要以同一个队列调用setWriteBack，脏数据才会在淘汰时写回；传入空指针恢复写穿透
+    //应在开始读写前调用，不与get/put并发
+    void setWriteBehind(std::shared_ptr<WriteBehindQueue<K, V>> queue)
+    {
+        writeBehind = std::move(queue);
+    }
+
+    //读穿透：缓存未命中时从存储加载并写入缓存，存储中也没有时返回false
+    bool get(const K& key, V& value)
+    {
+        if(cache.get(key, value))return true;
+        Loaded result = loadGroup.run(key, [&]() -> Loaded
+        {
+            //领头者再查一次，上一轮加载或预取可能刚好在本线程未命中之后写入
+            Loaded loaded;
+            if(cache.recheck(key, loaded.value))
+            {
+                loaded.found = true;
+                return loaded;
+            }
+            loaded.found = loadOne(key, loaded.value);
+            if(loaded.found)cache.putLoaded(key, loaded.value);
+            return loaded;
+        });
+        if(result.found)value = std::move(result.value);
+        return result.found;
+    }
+
+    V get(const K& key)
+    {
+        V value{};
+        get(key, value);
+        return value;
+    }
+
+    //批量读穿透：先批量查缓存，未命中的键一次loadMany，参数与返回值同CachePolicy::getMany
+    //批量路径不经过SingleFlight，与get并发加载同一个键时可能重复读存储，缓存中保留先写入的值
+    size_t getMany(const K* keys, size_t n, V* values, uint64_t* hitBits)
+    {
+        size_t hits = cache.getMany(keys, n, values, hitBits);
+        if(hits == n)return hits;
+        std::vector<size_t> order;
+        order.reserve(n - hits);
+        for(size_t i = 0; i < n; ++i)
+        {
+            if(!(hitBits[i / 64] >> (i % 64) & 1))order.push_back(i);
+        }
+        return hits + loadBatch(keys, order.data(), order.size(), values, hitBits);
+    }
+
+    //写穿透时持有键锁先写存储再写缓存，存储写入抛出异常时缓存不变；异步写回时只写缓存
+    void put(const K& key, const V& value)
+    {
+        if(writeBehind)
+        {
+            cache.put(key, value);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(writeStripes[writeStripeOf(key)].mtx);
+        store->store(key, value);
+        cache.put(key, value);
+    }
+
+    //写穿透时先锁住这批键所在的全部键锁段，再整批写存储与缓存
+    void putMany(const K* keys, const V* values, size_t n)
+    {
+        if(writeBehind)
+        {
+            cache.putMany(keys, values, n);
+            return;
+        }
+        uint64_t stripeMask = 0;
+        for(size_t i = 0; i < n; ++i)
+        {
+            stripeMask |= uint64_t(1) << writeStripeOf(keys[i]);
+        }
+        StripeLocks locks(writeStripes, stripeMask);
+        store->storeMany(keys, values, n);
+        cache.putMany(keys, values, n);
+    }
+
+    //异步预取：按PREFETCH_BATCH拆分后交给工作线程，立即返回；已在缓存中的键不会重复加载
+    void prefetch(const std::vector<K>& keys)
+    {
+        if(keys.empty())return;
+        {
+            std::lock_guard<std::mutex> lock(taskMtx);
+            for(size_t begin = 0; begin < keys.size(); begin += PREFETCH_BATCH)
+            {
+                size_t end = std::min(keys.size(), begin + PREFETCH_BATCH);
+                tasks.emplace_back(keys.begin() + begin, keys.begin() + end);
+            }
+        }
+        taskReady.notify_all();
+    }
+
+    //阻塞到已提交的预取任务全部完成
+    void waitIdle()
+    {
+        std::unique_lock<std::mutex> lock(taskMtx);
+        idle.wait(lock, [this] { return tasks.empty() && busyNum == 0; });
+    }
+
+    CachePolicy<K, V>& policy() { return cache; }
+
+    //从存储加载到的条数
+    size_t loads() const { return loadNum.load(std::memory_order_relaxed); }
+    //预取写入缓存的条数
+    size_t prefetched() const { return prefetchNum.load(std::memory_order_relaxed); }
+    //加载失败而放弃预取的条数
+    size_t prefetchFailed() const { return prefetchFailedNum.load(std::memory_order_relaxed); }
+};
+
+}
+#endif //MYCACHE_LOADINGCACHE_H
@@ -1,34 +1,48 @@
 #ifndef MYCACHE_LRUCACHE_H
 #define MYCACHE_LRUCACHE_H
 
+#include <algorithm>
 #include <list>
 #include <unordered_map>
 #include <memory>
 #include <mutex>
 #include <cstring>
+#include <cstdint>
+#include <cassert>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <utility>
 
 #include "CachePolicy.h"
+#include "CacheWeigher.h"
+#include "CompactHistory.h"
+#include "FlatHashMap.h"
+#include "ShardedCache.h"
+#include "TimingWheel.h"
+#include "WriteBehind.h"
 
 namespace mycache {
 
 //LRU缓存模板类前向声明
 template <typename K, typename V>class LruCache;
 
-//LRU缓存节点模板类
+//LRU缓存节点模板类，所有节点存放在LruCache预分配的数组中，通过32位下标互相链接
+//设置了过期时间的节点同时挂在时间轮上
 template <typename K, typename V>
-class LruNode 
+class LruNode : public TimerNode
 {
 public:
-    LruNode(const K& k, const V& v) 
-    : key(k)
-    , value(v)
+    LruNode() 
+    : key()
+    , value()
     , dirty(false)
-    , prev(nullptr)
-    , next(nullptr) {}
+    , prev(0)
+    , next(0) {}
 
     //必要的访问工具
     K getKey() const { return key; }
-    V getValue() const { return value; }
+    const V& getValue() const { return value; }
     void setValue(const V& v) { value = v; }
 
     friend class LruCache<K,V>;
@@ -36,9 +50,9 @@ public:
 private:
     K key;
     V value;
-    bool dirty;
-    std::shared_ptr<LruNode<K,V>> prev;
-    std::shared_ptr<LruNode<K,V>> next;
+    bool dirty;     //写入后尚未写回存储
+    uint32_t prev;  //前驱节点下标
+    uint32_t next;  //后继节点下标，空闲节点借用它串成空闲链表
 };
 
 //基础LRU缓存模板类
@@ -48,79 +62,351 @@ class LruCache: public CachePolicy<K,V>
 public:
     //重新定义类型名非常重要，确保不会出现类型混乱
     using LruNodeType = LruNode<K,V>;
-    using LruNodePtr = std::shared_ptr<LruNodeType>;
-    using LruNodeMap = std::unordered_map<K, LruNodePtr>;
+    using LruNodeIndex = uint32_t;
+    using LruNodeMap = FlatHashMap<K, LruNodeIndex>;
+    using Weigher = typename CacheWeight<K, V>::Weigher;
 
 private:
-    size_t capacity;    //缓存容量
-    std::mutex mtx;     //互斥锁，用于线程同步
-    LruNodeMap nodeMap; //节点哈希表，快速访问
-    LruNodePtr head;    //虚拟头结点，最久未使用
-    LruNodePtr tail;    //虚拟尾结点，最近使用
+    static constexpr LruNodeIndex HEAD = 0;         //虚拟头结点下标，最久未使用
+    static constexpr LruNodeIndex TAIL = 1;         //虚拟尾结点下标，最近使用
+    static constexpr LruNodeIndex NIL = UINT32_MAX; //空闲链表结束标记
+
+    size_t capacity;                //缓存容量
+    std::mutex mtx;                 //互斥锁，用于线程同步
+    LruNodeMap nodeMap;             //键到节点下标的哈希表，快速访问
+    std::vector<LruNodeType> nodes; //预分配的节点数组，下标0、1为头尾虚拟节点
+    LruNodeIndex freeList;          //空闲节点链表头
+    CacheWeight<K, V> weight;       //按权重限制容量时的记账
+    TimingWheel wheel;              //过期时间轮
+    ExpireMode expireMode;          //过期方式
+    uint32_t defaultTtl;            //未指定过期时间的写入使用的存活刻度数，0表示不过期
+    std::shared_ptr<WriteBehindQueue<K, V>> writeBack;  //脏数据写回队列，为空时淘汰直接丢弃数据
 
 private:
+    //重置链表与空闲链表
+    void resetNodes()
+    {
+        nodes[HEAD].prev = NIL;
+        nodes[HEAD].next = TAIL;
+        nodes[TAIL].prev = HEAD;
+        nodes[TAIL].next = NIL;
+        //数据节点全部串入空闲链表
+        freeList = NIL;
+        for(size_t i = nodes.size(); i > 2; --i)
+        {
+            nodes[i - 1].next = freeList;
+            freeList = static_cast<LruNodeIndex>(i - 1);
+        }
+    }
+    //从空闲链表中取出一个节点
+    LruNodeIndex allocNode()
+    {
+        LruNodeIndex index = freeList;
+        freeList = nodes[index].next;
+        return index;
+    }
+    //将节点归还到空闲链表
+    void freeNode(LruNodeIndex index)
+    {
+        nodes[index].next = freeList;
+        freeList = index;
+    }
     //移除节点
-    void removeNode(LruNodePtr node)
+    void removeNode(LruNodeIndex index)
     {
         //从链表中移除节点
-        node->prev->next = node->next;
-        node->next->prev = node->prev;
+        LruNodeType& node = nodes[index];
+        nodes[node.prev].next = node.next;
+        nodes[node.next].prev = node.prev;
     }
     //插入节点
-    void insertNode(LruNodePtr node)
+    void insertNode(LruNodeIndex index)
     {
         //将节点插入到最近使用的位置
-        node->next = tail;
-        node->prev = tail->prev;
-        tail->prev->next = node;
-        tail->prev = node;
+        LruNodeType& node = nodes[index];
+        node.next = TAIL;
+        node.prev = nodes[TAIL].prev;
+        nodes[node.prev].next = index;
+        nodes[TAIL].prev = index;
+    }
+    //离开缓存的节点是脏数据时把键值移入写回队列，节点随后复用或释放
+    void writeBackNode(LruNodeIndex index)
+    {
+        if(writeBack && nodes[index].dirty)
+        {
+            writeBack->enqueue(std::move(nodes[index].key), std::move(nodes[index].value));
+        }
+        nodes[index].dirty = false;
     }
     //淘汰节点
     void kickOut()
     {
         //移除最久未使用的节点
-        LruNodePtr leastRecentNode = head->next;
-        removeNode(leastRecentNode);
-        nodeMap.erase(leastRecentNode->getKey());
+        LruNodeIndex leastRecent = nodes[HEAD].next;
+        removeNode(leastRecent);
+        wheel.cancel(&nodes[leastRecent]);
+        nodeMap.erase(nodes[leastRecent].key);
+        weight.sub(weight.weigh(nodes[leastRecent].key, nodes[leastRecent].value));
+        writeBackNode(leastRecent);
+        freeNode(leastRecent);
+    }
+    //总权重超过上限时继续淘汰最久未使用的节点，被淘汰节点的值立即释放
+    void trimToWeight()
+    {
+        while(weight.overLimit() && !nodeMap.empty())
+        {
+            LruNodeIndex leastRecent = nodes[HEAD].next;
+            kickOut();
+            releaseValue(nodes[leastRecent].key);
+            releaseValue(nodes[leastRecent].value);
+        }
+    }
+    //删除到期的节点，时间轮已将其移出，被删除节点的值立即释放
+    void expireNode(LruNodeIndex index)
+    {
+        removeNode(index);
+        nodeMap.erase(nodes[index].key);
+        weight.sub(weight.weigh(nodes[index].key, nodes[index].value));
+        writeBackNode(index);
+        releaseValue(nodes[index].key);
+        releaseValue(nodes[index].value);
+        freeNode(index);
     }
-    //添加新节点
-    void addNewNode(const K& key, const V& value)
+    //处理已到期的数据并返回删除的条数，调用者已持有锁；没有设置过期时间的数据时不读取时钟
+    size_t expireDue()
+    {
+        if(wheel.empty())return 0;
+        return wheel.advance(wheel.now(), [this](TimerNode* timer)
+        {
+            expireNode(static_cast<LruNodeIndex>(static_cast<LruNodeType*>(timer) - nodes.data()));
+        });
+    }
+    //访问后续期，只在按访问过期时生效
+    void touch(LruNodeIndex index)
+    {
+        if(expireMode == ExpireMode::AfterAccess)wheel.restart(&nodes[index]);
+    }
+    //添加新节点，键和值直接转发到复用的节点中，返回节点下标
+    template <typename KK, typename... Args>
+    LruNodeIndex addNewNode(KK&& key, Args&&... args)
     {
         //若缓存空间已满，则替换掉最久未使用的节点
         if(nodeMap.size() >= capacity)
         {
             kickOut();
         }
-        //创建新节点并插入到最近使用的位置
-        LruNodePtr newNode = std::make_shared<LruNodeType>(key,value);
-        insertNode(newNode);
-        nodeMap[key] = newNode;
+        //复用空闲节点并插入到最近使用的位置
+        LruNodeIndex index = allocNode();
+        nodes[index].key = std::forward<KK>(key);
+        nodes[index].value = V(std::forward<Args>(args)...);
+        nodes[index].dirty = true;
+        insertNode(index);
+        nodeMap.emplace(nodes[index].key, index);
+        weight.add(weight.weigh(nodes[index].key, nodes[index].value));
+        return index;
     }
     //移动节点到最近使用的位置
-    void moveNodeToRecent(LruNodePtr node)
+    void moveNodeToRecent(LruNodeIndex index)
     {
-        //将节点移动到最近使用的位置
-        removeNode(node);
-        insertNode(node);
+        //已在最近使用的位置则无需移动
+        if(nodes[TAIL].prev == index)return;
+        removeNode(index);
+        insertNode(index);
     }
     //更新节点
-    void updateNode(LruNodePtr node, const V& value)
+    template <typename... Args>
+    void updateNode(LruNodeIndex index, Args&&... args)
     {
         //更新节点的值并移动到最近使用的位置
-        node->setValue(value);
-        moveNodeToRecent(node);
+        weight.sub(weight.weigh(nodes[index].key, nodes[index].value));
+        nodes[index].value = V(std::forward<Args>(args)...);
+        weight.add(weight.weigh(nodes[index].key, nodes[index].value));
+        nodes[index].dirty = true;
+        moveNodeToRecent(index);
+    }
+    //添加或更新缓存数据，ttl为存活刻度数（0表示不过期），调用者已持有锁
+    template <typename KK, typename... Args>
+    void putLocked(uint32_t ttl, KK&& key, Args&&... args)
+    {
+        LruNodeIndex index;
+        auto it = nodeMap.find(key);
+        if(it != nodeMap.end())
+        {
+            //节点已存在，更新节点的值并移动到最近使用的位置
+            index = it->second;
+            updateNode(index, std::forward<Args>(args)...);
+        }
+        else
+        {
+            //节点不存在，创建新节点并插入到最近使用的位置
+            index = addNewNode(std::forward<KK>(key), std::forward<Args>(args)...);
+        }
+        wheel.schedule(&nodes[index], ttl);
+        trimToWeight();
+    }
+    //插入从存储加载的数据，不标记为脏，调用者已持有锁并确认键不存在
+    void insertLoaded(const K& key, const V& value)
+    {
+        LruNodeIndex index = addNewNode(key, value);
+        nodes[index].dirty = false;
+        wheel.schedule(&nodes[index], defaultTtl);
+        trimToWeight();
+    }
+    //读-改-写缓存数据，调用者已持有锁
+    //fn以旧值的指针计算新值，键不存在时传入nullptr；新值写入缓存并返回
+    template <typename F>
+    V computeLocked(const K& key, F&& fn)
+    {
+        V value;
+        auto it = nodeMap.find(key);
+        if(it != nodeMap.end())
+        {
+            LruNodeIndex index = it->second;
+            updateNode(index, fn(static_cast<const V*>(&nodes[index].value)));
+            wheel.restart(&nodes[index]);
+            value = nodes[index].value;
+        }
+        else
+        {
+            value = fn(static_cast<const V*>(nullptr));
+            wheel.schedule(&nodes[addNewNode(key, value)], defaultTtl);
+        }
+        trimToWeight();
+        return value;
+    }
+    //把缓存中的全部脏数据复制到写回队列并标记为干净，调用者已持有锁
+    void writeBackAll()
+    {
+        if(!writeBack)return;
+        for(LruNodeIndex index = nodes[HEAD].next; index != TAIL; index = nodes[index].next)
+        {
+            if(!nodes[index].dirty)continue;
+            writeBack->enqueue(nodes[index].key, nodes[index].value);
+            nodes[index].dirty = false;
+        }
+    }
+    //访问缓存数据，调用者已持有锁
+    bool getLocked(const K& key, V& value)
+    {
+        auto it = nodeMap.find(key);
+        if(it != nodeMap.end())
+        {
+            //节点存在，移动到最近使用的位置
+            moveNodeToRecent(it->second);
+            touch(it->second);
+            value = nodes[it->second].value;
+            return true;
+        }
+        return false;
+    }
+
+protected:
+    //供派生类（LRU-k）在同一次加锁内先记录访问再操作缓存，onAccess(key)与admit(key)在持锁期间调用
+    //访问缓存数据，先调用onAccess(key)
+    template <typename OnAccess>
+    bool getWith(const K& key, V& value, OnAccess&& onAccess)
+    {
+        if(capacity <= 0)return false;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        expireDue();
+        onAccess(key);
+        return getLocked(key, value);
+    }
+    //原地访问缓存值，先调用onAccess(key)
+    template <typename OnAccess, typename F>
+    bool visitWith(const K& key, OnAccess&& onAccess, F&& fn)
+    {
+        if(capacity <= 0)return false;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        expireDue();
+        onAccess(key);
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end())return false;
+        moveNodeToRecent(it->second);
+        touch(it->second);
+        fn(static_cast<const V&>(nodes[it->second].value));
+        return true;
+    }
+    //添加缓存数据：键已在缓存中时直接更新，否则admit(key)返回true才插入
+    template <typename Admit, typename KK, typename... Args>
+    void putWith(Admit&& admit, KK&& key, Args&&... args)
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        if(!nodeMap.contains(key) && !admit(static_cast<const K&>(key)))return;
+        putLocked(defaultTtl, std::forward<KK>(key), std::forward<Args>(args)...);
+    }
+    //写入从存储加载的数据：键已在缓存中时保留缓存中的值，否则admit(key)返回true才以干净状态插入
+    template <typename Admit>
+    void putLoadedWith(Admit&& admit, const K& key, const V& value)
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        if(nodeMap.contains(key) || !admit(key))return;
+        insertLoaded(key, value);
+    }
+    //批量访问，整批只加一次锁，每个键先调用onAccess(key)
+    template <typename OnAccess>
+    size_t getBatchWith(const K* keys, const size_t* order, size_t n, V* values, uint64_t* hitBits, OnAccess&& onAccess)
+    {
+        if(capacity <= 0)return 0;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        expireDue();
+        size_t hits = 0;
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            onAccess(keys[i]);
+            if(getLocked(keys[i], values[i]))
+            {
+                hitBits[i / 64] |= uint64_t(1) << (i % 64);
+                ++hits;
+            }
+        }
+        return hits;
+    }
+    //批量添加，整批只加一次锁，不在缓存中的键由admit(key)决定是否插入
+    template <typename Admit>
+    void putBatchWith(const K* keys, const V* values, const size_t* order, size_t n, Admit&& admit)
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            if(!nodeMap.contains(keys[i]) && !admit(keys[i]))continue;
+            putLocked(defaultTtl, keys[i], values[i]);
+        }
     }
 
 public:
-    explicit LruCache(size_t n) : capacity(n) 
+    explicit LruCache(size_t n) 
+    : capacity(n)
+    , freeList(NIL)
+    , expireMode(ExpireMode::AfterWrite)
+    , defaultTtl(0)
     {
-        //创建头尾虚拟节点
-        head = std::make_shared<LruNodeType>(K(), V());
-        tail = std::make_shared<LruNodeType>(K(), V());
-        head->next = tail;
-        tail->prev = head;
+        //节点下标为32位，容量不能超过其表示范围
+        assert(capacity < NIL - 2);
+        //一次性分配全部节点（含头尾虚拟节点），之后的插入与淘汰不再分配节点
+        nodes.resize(capacity + 2);
+        nodeMap.reserve(capacity);
+        resetNodes();
+    }
+    //析构时把未写回的脏数据交给写回队列
+    ~LruCache()override
+    {
+        writeBackAll();
     }
-    ~LruCache()override = default;
     
     //添加缓存数据
     void put(const K& key, const V& value)override 
@@ -128,19 +414,51 @@ public:
         if(capacity <= 0)return;
         
         //上锁，避免多线程访问
-        std::lock_guard<std::mutex> lock(mtx);
-        auto it = nodeMap.find(key);
-        if(it != nodeMap.end())
-        {
-            //节点已存在，更新节点的值并移动到最近使用的位置
-            LruNodePtr node = it->second;
-            updateNode(node, value);
-        }
-        else
-        {
-            //节点不存在，创建新节点并插入到最近使用的位置
-            addNewNode(key, value);
-        }
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        putLocked(defaultTtl, key, value);
+    }
+
+    //添加缓存数据，键和值移动到节点中
+    void put(K&& key, V&& value)override
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        putLocked(defaultTtl, std::move(key), std::move(value));
+    }
+
+    //添加缓存数据并指定存活时间，ttl为0表示不过期；按访问过期时每次访问以ttl续期
+    void put(const K& key, const V& value, std::chrono::milliseconds ttl)
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        putLocked(wheel.toTicks(ttl), key, value);
+    }
+
+    //写入从存储加载的数据：键不存在时插入且不标记为脏，已存在时保留缓存中的值
+    void putLoaded(const K& key, const V& value)override
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        if(nodeMap.contains(key))return;
+        insertLoaded(key, value);
+    }
+
+    //原地构造缓存数据：args直接用于构造值，键已存在时以新构造的值替换旧值
+    template <typename KK, typename... Args>
+    void emplace(KK&& key, Args&&... args)
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        putLocked(defaultTtl, std::forward<KK>(key), std::forward<Args>(args)...);
     }
 
     //访问缓存数据
@@ -150,16 +468,8 @@ public:
 
         //上锁，避免多线程访问
         std::lock_guard<std::mutex> lock(mtx);
-        auto it = nodeMap.find(key);
-        if(it != nodeMap.end())
-        {
-            //节点存在，移动到最近使用的位置
-            LruNodePtr node = it->second;
-            moveNodeToRecent(node);
-            value = node->getValue();
-            return true;
-        }
-        return false;
+        expireDue();
+        return getLocked(key, value);
     }
 
     //访问缓存数据并直接返回键值
@@ -170,6 +480,92 @@ public:
         return value;
     }
 
+    //原地访问缓存值：命中时在持锁期间以const V&调用fn，不拷贝值，并与get一样更新访问状态
+    //fn返回后引用即失效，fn内不能再访问同一个缓存
+    template <typename F>
+    bool visit(const K& key, F&& fn)
+    {
+        if(capacity <= 0)return false;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        expireDue();
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end())return false;
+        moveNodeToRecent(it->second);
+        touch(it->second);
+        fn(static_cast<const V&>(nodes[it->second].value));
+        return true;
+    }
+
+    //原子地读-改-写：fn(const V* old)返回新值，键不存在时old为nullptr，新值写入缓存并返回
+    //查找、计算与写入在同一次加锁内完成；fn在持锁期间调用，fn内不能再访问同一个缓存
+    template <typename F>
+    V compute(const K& key, F&& fn)
+    {
+        if(capacity <= 0)return fn(static_cast<const V*>(nullptr));
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        return computeLocked(key, std::forward<F>(fn));
+    }
+
+    //键存在时以fn(const V& old)的返回值替换旧值，不存在时不写入，返回键是否存在
+    template <typename F>
+    bool computeIfPresent(const K& key, F&& fn)
+    {
+        if(capacity <= 0)return false;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end())return false;
+        updateNode(it->second, fn(static_cast<const V&>(nodes[it->second].value)));
+        wheel.restart(&nodes[it->second]);
+        trimToWeight();
+        return true;
+    }
+
+    //合并写入：键不存在时写入value，存在时写入fn(old, value)，返回写入的新值，适合计数器与聚合值
+    template <typename F>
+    V merge(const K& key, const V& value, F&& fn)
+    {
+        return compute(key, [&](const V* old) -> V { return old ? fn(*old, value) : value; });
+    }
+
+    //批量访问缓存数据，整批只加一次锁
+    size_t getBatch(const K* keys, const size_t* order, size_t n, V* values, uint64_t* hitBits)override
+    {
+        if(capacity <= 0)return 0;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        expireDue();
+        size_t hits = 0;
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            if(getLocked(keys[i], values[i]))
+            {
+                hitBits[i / 64] |= uint64_t(1) << (i % 64);
+                ++hits;
+            }
+        }
+        return hits;
+    }
+
+    //批量添加缓存数据，整批只加一次锁
+    void putBatch(const K* keys, const V* values, const size_t* order, size_t n)override
+    {
+        if(capacity <= 0)return;
+
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        expireDue();
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            putLocked(defaultTtl, keys[i], values[i]);
+        }
+    }
+
     //删除缓存数据
     void remove(const K& key)
     {
@@ -180,44 +576,226 @@ public:
         auto it = nodeMap.find(key);
         if(it != nodeMap.end())
         {
-            //节点存在，从哈希表和链表中移除
-            LruNodePtr node = it->second;
-            removeNode(node);
+            //节点存在，从哈希表和链表中移除，并归还到空闲链表
+            LruNodeIndex index = it->second;
+            removeNode(index);
+            wheel.cancel(&nodes[index]);
+            nodeMap.erase(it);
+            weight.sub(weight.weigh(nodes[index].key, nodes[index].value));
+            nodes[index].dirty = false;
+            nodes[index].key = K();
+            nodes[index].value = V();
+            freeNode(index);
         }
     }
 
     //清空缓存
     void purge()
     {
+        std::lock_guard<std::mutex> lock(mtx);
         nodeMap.clear();
-        head->next = tail;
-        tail->prev = head;
+        wheel.clear();
+        for(size_t i = 2; i < nodes.size(); ++i)
+        {
+            nodes[i].key = K();
+            nodes[i].value = V();
+            nodes[i].dirty = false;
+        }
+        resetNodes();
+        weight.reset();
     }
+
+    //设置权重上限（字节数），0表示只按条目数限制；超出上限时立即淘汰
+    //两种限制同时生效：条目数达到容量或总权重超过上限都会触发淘汰
+    void setMaxWeight(size_t maxWeight)
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        weight.setMaxWeight(maxWeight);
+        trimToWeight();
+    }
+
+    //设置权重函数，已缓存的数据按新函数重新计算总权重
+    void setWeigher(Weigher weigher)
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        weight.setWeigher(std::move(weigher));
+        weight.reset();
+        for(auto it = nodeMap.begin(); it != nodeMap.end(); ++it)
+        {
+            weight.add(weight.weigh(it->first, nodes[it->second].value));
+        }
+        trimToWeight();
+    }
+
+    //当前总权重
+    size_t totalWeight()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return weight.total();
+    }
+
+    //设置过期方式与默认存活时间，ttl为0表示未指定存活时间的写入不过期；只影响之后的写入
+    //AfterWrite：写入后经过ttl过期；AfterAccess：每次读写都以该数据自身的存活时间续期
+    void setExpiry(ExpireMode mode, std::chrono::milliseconds ttl)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        expireMode = mode;
+        defaultTtl = wheel.toTicks(ttl);
+    }
+
+    //维护入口：立即删除已到期的数据，返回删除的条数；平时每次读写都会顺带处理
+    size_t cleanUp()
+    {
+        WriteBackLock<K, V> lock(mtx, writeBack);
+        return expireDue();
+    }
+
+    //开启写回：写入的数据标记为脏，脏数据被淘汰或过期时放入写回队列，由队列的后台线程批量写回存储
+    //remove与purge删除的数据不写回；传入空指针关闭写回
+    void setWriteBack(std::shared_ptr<WriteBehindQueue<K, V>> queue)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        writeBack = std::move(queue);
+    }
+
+    //把缓存中的脏数据全部交给写回队列，并阻塞到队列写回完成；数据仍保留在缓存中
+    void flush()
+    {
+        std::shared_ptr<WriteBehindQueue<K, V>> queue;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            writeBackAll();
+            queue = writeBack;
+        }
+        if(queue)queue->flush();
+    }
+};
+
+//LRU-k的访问历史记录方式
+enum class LruKHistory
+{
+    Exact,      //完整的LRU链表（LruCache<K,size_t>）保存历史键与次数，历史表有自己的锁
+    Compact     //定长的指纹表（CompactHistory），每个历史键2字节，在缓存的锁内记录
 };
 
 //LRU-k缓存模板类
+//Exact模式：每次get要对历史表get、put各加一次锁，再锁缓存，每个历史键的内存与一个缓存条目相当
+//Compact模式：历史记录与缓存操作在同一次加锁内完成，批量操作整批只加一次锁；访问次数上限15，k最大取14
 template<typename K, typename V>
 class LruKCache:public LruCache<K,V>
 {
 private:
     int k;                                          //判断是否进入缓存队列的k值
-    std::unique_ptr<LruCache<K,size_t>> historyList;//访问历史记录链表
+    std::unique_ptr<LruCache<K,size_t>> historyList;//访问历史记录链表，Exact模式
+    std::unique_ptr<CompactHistory<K>> history;     //访问历史指纹表，Compact模式，只在基类的锁内访问
+
+    //Compact模式：记录一次访问
+    auto recordAccess()
+    {
+        return [this](const K& key) { history->record(key); };
+    }
+    //Compact模式：记录一次访问，此前已访问过k次时准入并删除历史
+    auto admitAfterK()
+    {
+        return [this](const K& key)
+        {
+            if(static_cast<int>(history->record(key)) <= k)return false;
+            history->erase(key);
+            return true;
+        };
+    }
+
+    //Exact模式：记录一次访问，此前已访问过k次时准入并删除历史；在基类的锁内调用，历史链表自带锁，加锁顺序固定为先基类后历史
+    auto admitExact()
+    {
+        return [this](const K& key)
+        {
+            int historyCount = historyList->get(key);
+            if(historyCount >= k)
+            {
+                historyList->remove(key);
+                return true;
+            }
+            historyList->put(key, historyCount + 1);
+            return false;
+        };
+    }
 
 public:
-    LruKCache(size_t n, size_t historyCapacity, int k_) 
+    //n：缓存容量；historyCapacity：历史记录的键数；k_：进入缓存前需要的访问次数；mode：历史记录方式
+    LruKCache(size_t n, size_t historyCapacity, int k_, LruKHistory mode = LruKHistory::Exact)
     : LruCache<K,V>(n) 
-    , k(k_)
-    , historyList(std::make_unique<LruCache<K,size_t>>(historyCapacity))
-    {}
+    , k(mode == LruKHistory::Compact ? std::min(k_, 14) : k_)
+    {
+        if(mode == LruKHistory::Compact)history = std::make_unique<CompactHistory<K>>(historyCapacity);
+        else historyList = std::make_unique<LruCache<K,size_t>>(historyCapacity);
+    }
     ~LruKCache()override = default;
 
-    void put(const K& key, const V& value) 
+    //原地访问缓存值，同样先记录一次访问历史
+    template <typename F>
+    bool visit(const K& key, F&& fn)
+    {
+        if(history)return this->visitWith(key, recordAccess(), std::forward<F>(fn));
+        int historyCount = historyList->get(key);
+        historyList->put(key, historyCount + 1);
+        return LruCache<K,V>::visit(key, std::forward<F>(fn));
+    }
+
+    //LRU-k的每次访问都要经过历史记录：Exact模式逐个转发，Compact模式整批只加一次锁
+    size_t getBatch(const K* keys, const size_t* order, size_t n, V* values, uint64_t* hitBits)override
+    {
+        if(history)return this->getBatchWith(keys, order, n, values, hitBits, recordAccess());
+        return CachePolicy<K,V>::getBatch(keys, order, n, values, hitBits);
+    }
+    void putBatch(const K* keys, const V* values, const size_t* order, size_t n)override
     {
-        V tempValue{};
-        if(LruCache<K,V>::get(key,tempValue))
+        if(history)
+        {
+            this->putBatchWith(keys, values, order, n, admitAfterK());
+            return;
+        }
+        CachePolicy<K,V>::putBatch(keys, values, order, n);
+    }
+
+    void put(const K& key, const V& value) override
+    {
+        emplace(key, value);
+    }
+
+    void put(K&& key, V&& value) override
+    {
+        emplace(std::move(key), std::move(value));
+    }
+
+    //加载的数据同样要满足k次访问历史才进入缓存：与put一样记录一次访问，只加一次锁，准入后以干净状态插入
+    //键已在缓存中时不记录访问，保留缓存中的值
+    void putLoaded(const K& key, const V& value) override
+    {
+        if(history)this->putLoadedWith(admitAfterK(), key, value);
+        else this->putLoadedWith(admitExact(), key, value);
+    }
+
+    //加载前的复查不算作一次新的访问，只查缓存，不记录访问历史
+    bool recheck(const K& key, V& value) override
+    {
+        return LruCache<K,V>::get(key, value);
+    }
+
+    //原地构造缓存数据，与put一样需要先满足k次访问历史
+    template <typename KK, typename... Args>
+    void emplace(KK&& key, Args&&... args)
+    {
+        if(history)
+        {
+            this->putWith(admitAfterK(), std::forward<KK>(key), std::forward<Args>(args)...);
+            return;
+        }
+
+        if(LruCache<K,V>::visit(key, [](const V&) {}))
         {
             //若已存在于缓存中，则更新缓存数据并移动到最近使用的位置
-            LruCache<K,V>::put(key,value);
+            LruCache<K,V>::emplace(std::forward<KK>(key), std::forward<Args>(args)...);
             return;
         }
 
@@ -231,13 +809,14 @@ public:
             //移除历史访问记录
             historyList->remove(key);
             //放入缓存队列
-            LruCache<K,V>::put(key,value);
+            LruCache<K,V>::emplace(std::forward<KK>(key), std::forward<Args>(args)...);
             return;
         }
     }
 
     bool get(const K& key, V& value)
     {
+        if(history)return this->getWith(key, value, recordAccess());
         //获取历史访问次数
         int historyCount = historyList->get(key);
         //更新历史访问次数
@@ -247,61 +826,21 @@ public:
     }
     V get(const K& key)
     {
-        //获取访问次数
-        int historyCount = historyList->get(key);
-        //更新访问次数
-        historyList->put(key,historyCount+1);
-        //获取缓存数据,但不一定存在
-        return LruCache<K,V>::get(key);
+        V value{};
+        get(key, value);
+        return value;
     }
 
 };
 
-template<typename K, typename V>
-class HashLruCache
+//按键的哈希值分片的LRU缓存，各切片独立加锁，分片逻辑见ShardedCache
+template <typename K, typename V>
+class HashLruCache : public ShardedCache<LruCache<K, V>>
 {
-private:
-    size_t capacity;                                        //缓存容量
-    int sliceNum;                                           //切片数量
-    std::vector<std::unique_ptr<LruCache<K,V>>> sliceCaches;//切片缓存
-
-private:
-    //将key转换为对应hash值
-    size_t Hash(const K& key)
-    {   
-        std::hash<K> hashFunc;
-        return hashFunc(key);
-    }
-
 public:
-    HashLruCache(size_t n, int sliceNum_)
-    : capacity(n)
-    , sliceNum(sliceNum_) 
-    {
-        size_t sliceSize = ceil(capacity / static_cast<double>(sliceNum));
-        for(int i=0;i<sliceNum;++i)
-        {
-            sliceCaches.emplace_back(std::make_unique<LruCache<K,V>>(sliceSize));
-        }
-    }
-    void put(const K& key, const V& value) 
-    {
-        //将key转换为对应hash值，计算出对应的切片索引
-        size_t sliceIndex = Hash(key) % sliceNum;
-        sliceCaches[sliceIndex]->put(key,value);
-    }
-    bool get(const K& key, V& value)
-    {
-        //将key转换为对应hash值，计算出对应的切片索引
-        size_t sliceIndex = Hash(key) % sliceNum;
-        return sliceCaches[sliceIndex]->get(key,value);
-    }
-    V get(const K& key)
-    {
-        V value{};
-        get(key,value);
-        return value;
-    }
+    //n：总容量；sliceNum：切片数量，向上取整为2的幂
+    HashLruCache(size_t n, int sliceNum)
+    : ShardedCache<LruCache<K, V>>(n, sliceNum > 0 ? static_cast<size_t>(sliceNum) : 1) {}
 };
 
 }
@@ -0,0 +1,99 @@
+#ifndef MYCACHE_READBUFFER_H
+#define MYCACHE_READBUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#include "HashUtil.h"
+
+namespace mycache {
+
+//有损的分段读缓冲：读者把命中记录写入缓冲，由持有缓存锁的线程按批回放
+//  - 分段数为不小于CPU核数的2的幂，每个线程按线程号的哈希固定写入一个分段，不同线程很少争用同一个计数器
+//  - 每个分段是定长的环形数组，写满或抢占写位置失败时直接丢弃记录，读者从不等待
+//  - 记录为非0的64位整数，含义由所属缓存决定
+//回放只能由一个线程进行（所属缓存的锁内），写入可以与回放并发
+class ReadBuffer
+{
+public:
+    static constexpr size_t STRIPE_SIZE = 32;   //每个分段的记录数
+
+private:
+    static constexpr size_t STRIPE_MASK = STRIPE_SIZE - 1;
+
+    struct alignas(64) Stripe
+    {
+        std::atomic<uint64_t> writeCount;       //已分配的写位置数
+        std::atomic<uint64_t> readCount;        //已回放的记录数，只由回放线程修改
+        std::atomic<uint64_t> entries[STRIPE_SIZE];
+        Stripe() : writeCount(0), readCount(0)
+        {
+            for(auto& entry : entries)entry.store(0, std::memory_order_relaxed);
+        }
+    };
+
+    size_t stripeMask;
+    std::unique_ptr<Stripe[]> stripes;
+
+    //当前线程固定使用的分段
+    Stripe& localStripe()
+    {
+        static thread_local size_t probe = static_cast<size_t>(
+            hashMix(static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id()))));
+        return stripes[probe & stripeMask];
+    }
+
+public:
+    ReadBuffer()
+    : stripeMask(0)
+    {
+        size_t cores = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        size_t stripeNum = 1;
+        while(stripeNum < cores)stripeNum <<= 1;
+        stripeMask = stripeNum - 1;
+        stripes.reset(new Stripe[stripeNum]);
+    }
+
+    //写入一条记录，返回所在分段待回放的记录数；分段已满或与其他线程争用时丢弃记录并返回STRIPE_SIZE
+    size_t record(uint64_t entry)
+    {
+        Stripe& stripe = localStripe();
+        uint64_t write = stripe.writeCount.load(std::memory_order_relaxed);
+        uint64_t read = stripe.readCount.load(std::memory_order_acquire);
+        if(write - read >= STRIPE_SIZE)return STRIPE_SIZE;
+        if(!stripe.writeCount.compare_exchange_strong(write, write + 1, std::memory_order_relaxed))return STRIPE_SIZE;
+        stripe.entries[write & STRIPE_MASK].store(entry, std::memory_order_release);
+        return static_cast<size_t>(write + 1 - read);
+    }
+
+    //回放全部分段中已写完的记录，对每条记录调用fn(entry)，返回回放的条数；调用者保证同一时刻只有一个回放线程
+    template <typename F>
+    size_t drain(F&& fn)
+    {
+        size_t drained = 0;
+        for(size_t s = 0; s <= stripeMask; ++s)
+        {
+            Stripe& stripe = stripes[s];
+            uint64_t read = stripe.readCount.load(std::memory_order_relaxed);
+            uint64_t write = stripe.writeCount.load(std::memory_order_acquire);
+            for(; read < write; ++read)
+            {
+                //写位置已分配但记录尚未写入，留到下次回放
+                uint64_t entry = stripe.entries[read & STRIPE_MASK].exchange(0, std::memory_order_acquire);
+                if(entry == 0)break;
+                fn(entry);
+                ++drained;
+            }
+            stripe.readCount.store(read, std::memory_order_release);
+        }
+        return drained;
+    }
+};
+
+}
+#endif //MYCACHE_READBUFFER_H
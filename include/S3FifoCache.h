@@ -0,0 +1,330 @@
+#ifndef MYCACHE_S3FIFOCACHE_H
+#define MYCACHE_S3FIFOCACHE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "CachePolicy.h"
+#include "ConcurrentIndex.h"
+#include "FlatHashMap.h"
+#include "ShardedCache.h"
+
+namespace mycache {
+
+//S3-FIFO中数据所在的队列
+enum class S3FifoQueueId
+{
+    Small,  //试用队列：新数据先进入这里
+    Main    //主队列：在试用队列中被再次访问过，或刚从幽灵队列中回来的数据
+};
+
+//S3-FIFO缓存（Yang et al., SOSP'23），三个FIFO队列，命中只把2位访问计数加1，从不移动节点：
+//  - 试用队列S占容量的10%，主队列M占其余部分；新数据进入S，键在幽灵队列G中时直接进入M
+//  - S满时淘汰最旧的数据：期间被访问过的移入M，否则删除并把键的哈希值记入G
+//  - M满时淘汰最旧的数据：访问计数大于0的计数减一后重新放到M的最新端，否则删除
+//  - G只保存键的哈希值，按FIFO保留最近的M容量个，只访问一次的数据（如扫描）很快从S中离开，不会冲刷M
+//查找与ConcurrentClockCache相同，get完全不加锁：无锁探测ConcurrentIndex，按顺序锁读出键值，
+//访问计数以relaxed读写，并发命中丢失一次计数只会影响淘汰顺序；put、remove与淘汰由互斥锁串行化
+//顺序锁读取要求按字节拷贝键值，因此K和V必须是可平凡拷贝的类型
+template <typename K, typename V>
+class S3FifoCache : public CachePolicy<K, V>
+{
+    static_assert(std::is_trivially_copyable<K>::value, "S3FifoCache requires a trivially copyable key");
+    static_assert(std::is_trivially_copyable<V>::value, "S3FifoCache requires a trivially copyable value");
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+    static constexpr uint8_t MAX_FREQ = 3;      //访问计数上限
+
+    struct Slot : SeqlockEntry<K, V>
+    {
+        std::atomic<uint8_t> freq;      //访问计数，读者用relaxed写入
+        uint32_t older;                 //所在队列中较旧的相邻槽位，只由持锁的写者访问
+        uint32_t newer;                 //所在队列中较新的相邻槽位
+        S3FifoQueueId queue;            //所在队列
+        bool occupied;                  //是否存有数据
+        Slot() : freq(0), older(NIL), newer(NIL), queue(S3FifoQueueId::Small), occupied(false) {}
+    };
+
+    //以槽位下标串起的FIFO队列
+    struct Queue
+    {
+        uint32_t oldest = NIL;
+        uint32_t newest = NIL;
+        size_t size = 0;
+    };
+
+    size_t capacity;                    //缓存容量
+    size_t smallCapacity;               //试用队列的容量
+    size_t ghostCapacity;               //幽灵队列保留的键数
+    std::unique_ptr<Slot[]> slots;      //槽位数组
+    ConcurrentIndex<K> index;           //键到槽位的并发索引
+    std::vector<uint32_t> freeSlots;    //空闲槽位
+    Queue queues[2];                    //按S3FifoQueueId排列的试用队列与主队列
+    std::vector<uint64_t> ghostRing;    //幽灵队列，按写入顺序保存键的哈希值
+    size_t ghostNext;                   //幽灵队列下一个写入位置
+    FlatHashMap<uint64_t, uint32_t> ghostSet;   //幽灵队列中的哈希值及其出现次数
+    std::mutex mtx;                     //写者互斥锁
+
+private:
+    Queue& queueOf(S3FifoQueueId id) { return queues[static_cast<int>(id)]; }
+
+    static uint64_t ghostHashOf(const K& key)
+    {
+        return hashMix(static_cast<uint64_t>(std::hash<K>()(key)));
+    }
+    size_t findEntry(const K& key, uint32_t hash) const
+    {
+        return index.find(key, hash, [this](size_t slot) -> const K& { return slots[slot].key; });
+    }
+    void pushNewest(S3FifoQueueId id, uint32_t i)
+    {
+        Queue& queue = queueOf(id);
+        Slot& slot = slots[i];
+        slot.queue = id;
+        slot.older = queue.newest;
+        slot.newer = NIL;
+        if(queue.newest != NIL)slots[queue.newest].newer = i;
+        else queue.oldest = i;
+        queue.newest = i;
+        queue.size++;
+    }
+    void unlink(uint32_t i)
+    {
+        Slot& slot = slots[i];
+        Queue& queue = queueOf(slot.queue);
+        if(slot.older != NIL)slots[slot.older].newer = slot.newer;
+        else queue.oldest = slot.newer;
+        if(slot.newer != NIL)slots[slot.newer].older = slot.older;
+        else queue.newest = slot.older;
+        slot.older = slot.newer = NIL;
+        queue.size--;
+    }
+    //记入幽灵队列，队列已满时挤掉最旧的哈希值
+    void addGhost(uint64_t h)
+    {
+        if(ghostCapacity == 0)return;
+        if(ghostRing.size() < ghostCapacity)
+        {
+            ghostRing.push_back(h);
+        }
+        else
+        {
+            uint64_t old = ghostRing[ghostNext];
+            auto it = ghostSet.find(old);
+            if(--it->second == 0)ghostSet.erase(it);
+            ghostRing[ghostNext] = h;
+            ghostNext = (ghostNext + 1) % ghostCapacity;
+        }
+        auto it = ghostSet.find(h);
+        if(it != ghostSet.end())it->second++;
+        else ghostSet.emplace(h, 1u);
+    }
+    //删除槽位中的数据并归还槽位
+    void release(uint32_t i)
+    {
+        unlink(i);
+        index.erase(findEntry(slots[i].key, ConcurrentIndex<K>::hashOf(slots[i].key)));
+        slots[i].occupied = false;
+        freeSlots.push_back(i);
+    }
+    //淘汰试用队列最旧的数据：被访问过的移入主队列，否则删除并记入幽灵队列；返回是否腾出了槽位
+    bool evictSmall()
+    {
+        uint32_t i = queueOf(S3FifoQueueId::Small).oldest;
+        if(slots[i].freq.load(std::memory_order_relaxed) > 0)
+        {
+            slots[i].freq.store(0, std::memory_order_relaxed);
+            unlink(i);
+            pushNewest(S3FifoQueueId::Main, i);
+            return false;
+        }
+        addGhost(ghostHashOf(slots[i].key));
+        release(i);
+        return true;
+    }
+    //淘汰主队列最旧的数据：访问计数大于0的计数减一后重新放到最新端，否则删除
+    //读者会并发增加计数，最多检查主队列大小的MAX_FREQ+1倍后强制淘汰当前数据
+    void evictMain()
+    {
+        Queue& main = queueOf(S3FifoQueueId::Main);
+        for(size_t step = 0; step < (MAX_FREQ + 1) * main.size; ++step)
+        {
+            uint32_t i = main.oldest;
+            uint8_t freq = slots[i].freq.load(std::memory_order_relaxed);
+            if(freq == 0)break;
+            slots[i].freq.store(freq - 1, std::memory_order_relaxed);
+            unlink(i);
+            pushNewest(S3FifoQueueId::Main, i);
+        }
+        release(main.oldest);
+    }
+    //腾出一个槽位：试用队列达到容量（或主队列为空）时先淘汰试用队列，否则淘汰主队列
+    void makeRoom()
+    {
+        while(freeSlots.empty())
+        {
+            Queue& small = queueOf(S3FifoQueueId::Small);
+            if(small.size > 0 && (small.size >= smallCapacity || queueOf(S3FifoQueueId::Main).size == 0))
+            {
+                evictSmall();
+            }
+            else
+            {
+                evictMain();
+            }
+        }
+    }
+    //添加或更新缓存，调用者已持有锁；更新原地进行，不改变队列位置
+    void putLocked(const K& key, const V& value)
+    {
+        uint32_t hash = ConcurrentIndex<K>::hashOf(key);
+        size_t pos = findEntry(key, hash);
+        if(pos != ConcurrentIndex<K>::NPOS)
+        {
+            Slot& slot = slots[index.slotAt(pos)];
+            slot.write(key, value);
+            uint8_t freq = slot.freq.load(std::memory_order_relaxed);
+            if(freq < MAX_FREQ)slot.freq.store(freq + 1, std::memory_order_relaxed);
+            return;
+        }
+
+        makeRoom();
+        uint32_t i = freeSlots.back();
+        freeSlots.pop_back();
+        Slot& slot = slots[i];
+        slot.write(key, value);
+        slot.occupied = true;
+        slot.freq.store(0, std::memory_order_relaxed);
+        bool ghost = ghostSet.contains(ghostHashOf(key));
+        pushNewest(ghost ? S3FifoQueueId::Main : S3FifoQueueId::Small, i);
+        index.insert(hash, i);
+    }
+
+public:
+    explicit S3FifoCache(size_t n)
+    : capacity(n)
+    , smallCapacity(std::max<size_t>(n / 10, 1))
+    , ghostCapacity(n > smallCapacity ? n - smallCapacity : 0)
+    , index(n)
+    , ghostNext(0)
+    {
+        assert(capacity < NIL);
+        slots.reset(new Slot[capacity > 0 ? capacity : 1]);
+        freeSlots.reserve(capacity);
+        for(size_t i = capacity; i > 0; --i)
+        {
+            freeSlots.push_back(static_cast<uint32_t>(i - 1));
+        }
+        ghostRing.reserve(ghostCapacity);
+        ghostSet.reserve(ghostCapacity);
+    }
+    ~S3FifoCache() override = default;
+
+    //无锁读取：探测索引，按顺序锁读出槽位，访问计数未到上限时加一
+    bool get(const K& key, V& value) override
+    {
+        if(capacity <= 0)return false;
+
+        return index.probe(ConcurrentIndex<K>::hashOf(key), [&](size_t i)
+        {
+            Slot& slot = slots[i];
+            if(!slot.read(key, value))return false;
+            uint8_t freq = slot.freq.load(std::memory_order_relaxed);
+            if(freq < MAX_FREQ)slot.freq.store(freq + 1, std::memory_order_relaxed);
+            return true;
+        });
+    }
+
+    V get(const K& key) override
+    {
+        V value{};
+        get(key, value);
+        return value;
+    }
+
+    void put(const K& key, const V& value) override
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        putLocked(key, value);
+    }
+
+    //与其他策略接口一致的访问方式：值可平凡拷贝，按顺序锁读出副本后调用fn
+    template <typename F>
+    bool visit(const K& key, F&& fn)
+    {
+        V value;
+        if(!get(key, value))return false;
+        fn(static_cast<const V&>(value));
+        return true;
+    }
+
+    //与其他策略接口一致的原地构造：值可平凡拷贝，构造后按值写入
+    template <typename KK, typename... Args>
+    void emplace(KK&& key, Args&&... args)
+    {
+        put(K(std::forward<KK>(key)), V(std::forward<Args>(args)...));
+    }
+
+    //批量写入，整批只加一次写者锁；批量读取沿用逐个无锁读取的默认实现
+    void putBatch(const K* keys, const V* values, const size_t* order, size_t n) override
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            putLocked(keys[i], values[i]);
+        }
+    }
+
+    //删除缓存数据，不记入幽灵队列
+    void remove(const K& key)
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t pos = findEntry(key, ConcurrentIndex<K>::hashOf(key));
+        if(pos == ConcurrentIndex<K>::NPOS)return;
+        release(static_cast<uint32_t>(index.slotAt(pos)));
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        index.clear();
+        freeSlots.clear();
+        for(size_t i = capacity; i > 0; --i)
+        {
+            slots[i - 1].occupied = false;
+            slots[i - 1].older = slots[i - 1].newer = NIL;
+            freeSlots.push_back(static_cast<uint32_t>(i - 1));
+        }
+        queues[0] = queues[1] = Queue();
+        ghostRing.clear();
+        ghostNext = 0;
+        ghostSet.clear();
+    }
+};
+
+//分片S3-FIFO缓存，各分片独立加锁，分片逻辑见ShardedCache
+template <typename K, typename V>
+class HashS3FifoCache : public ShardedCache<S3FifoCache<K, V>>
+{
+public:
+    //n：总容量；sliceNum：切片数量，向上取整为2的幂
+    HashS3FifoCache(size_t n, int sliceNum)
+    : ShardedCache<S3FifoCache<K, V>>(n, sliceNum > 0 ? static_cast<size_t>(sliceNum) : 1) {}
+};
+
+}
+#endif //MYCACHE_S3FIFOCACHE_H
@@ -0,0 +1,365 @@
+#ifndef MYCACHE_SHARDEDCACHE_H
+#define MYCACHE_SHARDEDCACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "CachePolicy.h"
+#include "HashUtil.h"
+
+namespace mycache {
+
+//缓存行大小，分片之间按此对齐，相邻分片的互斥锁不会落在同一缓存行上
+constexpr size_t CACHE_LINE_SIZE = 64;
+
+//通用分片缓存：把键空间切分到多个独立加锁的缓存实例上，降低锁竞争
+//Policy为任意CachePolicy派生的缓存策略，构造函数第一个参数为容量
+//  - 分片数向上取整为2的幂，用掩码代替取模选择分片
+//  - 分片前先对std::hash的结果做二次混合，避免连续整数键按固定规律落到相邻分片
+//  - 全部分片连续存放在一块按缓存行对齐的内存中，每个分片独占整数个缓存行
+template <typename Policy>
+class ShardedCache : public CachePolicy<typename Policy::key_type, typename Policy::mapped_type>
+{
+public:
+    using key_type = typename Policy::key_type;
+    using mapped_type = typename Policy::mapped_type;
+    using K = key_type;
+    using V = mapped_type;
+
+private:
+    //按缓存行对齐的分片，sizeof也会被补齐到缓存行的整数倍
+    struct alignas(CACHE_LINE_SIZE) Shard
+    {
+        Policy cache;
+        template <typename... Args>
+        explicit Shard(Args&&... args) : cache(std::forward<Args>(args)...) {}
+    };
+
+    size_t capacity;        //总容量
+    size_t shardNum;        //分片数量，为2的幂
+    size_t shardMask;       //分片掩码
+    Shard* shards;          //分片数组
+
+private:
+    static size_t roundUpPow2(size_t n)
+    {
+        size_t result = 1;
+        while(result < n)result <<= 1;
+        return result;
+    }
+    //批量操作的分组缓冲
+    struct BatchScratch
+    {
+        std::vector<size_t> shardOf;    //每个下标所在的分片
+        std::vector<size_t> cursor;     //各分片的写入位置
+        std::vector<size_t> grouped;    //按分片分组后的下标
+        std::vector<size_t> offsets;    //各分片在grouped中的起点
+    };
+    //当前线程复用的分组缓冲，容量只增不减，批量大小稳定后不再分配内存
+    //分组结果只在一次批量操作内使用，分片策略不会再调用同一个ShardedCache的批量操作，不会重入
+    static BatchScratch& scratch()
+    {
+        static thread_local BatchScratch buffers;
+        return buffers;
+    }
+    //把order给出的下标按所在分片分组：grouped中第s个分片的下标位于[offsets[s], offsets[s+1])，组内保持原顺序
+    //结果存放在当前线程的分组缓冲中，下一次分组前有效
+    const BatchScratch& groupByShard(const K* keys, const size_t* order, size_t n) const
+    {
+        BatchScratch& buf = scratch();
+        buf.shardOf.resize(n);
+        buf.offsets.assign(shardNum + 1, 0);
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t s = shardIndex(keys[order ? order[j] : j]);
+            buf.shardOf[j] = s;
+            buf.offsets[s + 1]++;
+        }
+        for(size_t s = 0; s < shardNum; ++s)
+        {
+            buf.offsets[s + 1] += buf.offsets[s];
+        }
+        buf.grouped.resize(n);
+        buf.cursor.assign(buf.offsets.begin(), buf.offsets.end() - 1);
+        for(size_t j = 0; j < n; ++j)
+        {
+            buf.grouped[buf.cursor[buf.shardOf[j]]++] = order ? order[j] : j;
+        }
+        return buf;
+    }
+
+public:
+    //n：总容量；shardCount：期望的分片数，向上取整为2的幂；args：转发给每个分片构造函数的其余参数
+    //每个分片的容量为总容量除以分片数向上取整
+    template <typename... Args>
+    ShardedCache(size_t n, size_t shardCount, Args&&... args)
+    : capacity(n)
+    , shardNum(roundUpPow2(shardCount > 0 ? shardCount : 1))
+    , shardMask(shardNum - 1)
+    , shards(nullptr)
+    {
+        size_t shardCapacity = (capacity + shardNum - 1) / shardNum;
+        shards = static_cast<Shard*>(::operator new(sizeof(Shard) * shardNum, std::align_val_t(alignof(Shard))));
+        size_t built = 0;
+        try
+        {
+            for(; built < shardNum; ++built)
+            {
+                new (&shards[built]) Shard(shardCapacity, args...);
+            }
+        }
+        catch(...)
+        {
+            while(built > 0)shards[--built].~Shard();
+            ::operator delete(shards, std::align_val_t(alignof(Shard)));
+            throw;
+        }
+    }
+
+    ShardedCache(const ShardedCache&) = delete;
+    ShardedCache& operator=(const ShardedCache&) = delete;
+
+    ~ShardedCache() override
+    {
+        for(size_t i = 0; i < shardNum; ++i)
+        {
+            shards[i].~Shard();
+        }
+        ::operator delete(shards, std::align_val_t(alignof(Shard)));
+    }
+
+    //计算键所在的分片下标
+    size_t shardIndex(const K& key) const
+    {
+        return static_cast<size_t>(hashMix(static_cast<uint64_t>(std::hash<K>()(key)))) & shardMask;
+    }
+    //键所在的分片
+    Policy& shardFor(const K& key) { return shards[shardIndex(key)].cache; }
+    //第i个分片
+    Policy& shard(size_t i) { return shards[i].cache; }
+    //分片数量
+    size_t shardCount() const { return shardNum; }
+
+    void put(const K& key, const V& value) override
+    {
+        shardFor(key).put(key, value);
+    }
+
+    void put(K&& key, V&& value) override
+    {
+        Policy& cache = shardFor(key);
+        cache.put(std::move(key), std::move(value));
+    }
+
+    void putLoaded(const K& key, const V& value) override
+    {
+        shardFor(key).putLoaded(key, value);
+    }
+
+    bool recheck(const K& key, V& value) override
+    {
+        return shardFor(key).recheck(key, value);
+    }
+
+    //添加缓存数据并指定存活时间，转发给键所在的分片，要求分片策略支持过期
+    template <typename Duration>
+    void put(const K& key, const V& value, Duration ttl)
+    {
+        shardFor(key).put(key, value, ttl);
+    }
+
+    //原地构造缓存数据，转发给键所在的分片，要求分片策略提供emplace
+    template <typename KK, typename... Args>
+    void emplace(KK&& key, Args&&... args)
+    {
+        Policy& cache = shardFor(key);
+        cache.emplace(std::forward<KK>(key), std::forward<Args>(args)...);
+    }
+
+    bool get(const K& key, V& value) override
+    {
+        return shardFor(key).get(key, value);
+    }
+
+    V get(const K& key) override
+    {
+        V value{};
+        get(key, value);
+        return value;
+    }
+
+    //删除缓存数据，转发给键所在的分片，要求分片策略提供remove
+    void remove(const K& key)
+    {
+        shardFor(key).remove(key);
+    }
+
+    //按键集合批量删除n个键：先按分片分组，每个分片整批转发一次，要求分片策略提供removeBatch；返回实际删除的条数
+    size_t removeMany(const K* keys, size_t n)
+    {
+        if(shardNum == 1)return shards[0].cache.removeBatch(keys, nullptr, n);
+
+        const BatchScratch& buf = groupByShard(keys, nullptr, n);
+        const std::vector<size_t>& grouped = buf.grouped;
+        const std::vector<size_t>& offsets = buf.offsets;
+        size_t removed = 0;
+        for(size_t s = 0; s < shardNum; ++s)
+        {
+            size_t count = offsets[s + 1] - offsets[s];
+            if(count == 0)continue;
+            removed += shards[s].cache.removeBatch(keys, grouped.data() + offsets[s], count);
+        }
+        return removed;
+    }
+
+    //读取或加载缓存，转发给键所在的分片，并发加载的合并也在分片内进行
+    template <typename F>
+    V getOrLoad(const K& key, F&& loader)
+    {
+        return shardFor(key).getOrLoad(key, std::forward<F>(loader));
+    }
+
+    //原地访问缓存值，转发给键所在的分片，要求分片策略提供visit
+    template <typename F>
+    bool visit(const K& key, F&& fn)
+    {
+        return shardFor(key).visit(key, std::forward<F>(fn));
+    }
+
+    //原子地读-改-写，转发给键所在的分片，整个过程只锁该分片一次
+    template <typename F>
+    V compute(const K& key, F&& fn)
+    {
+        return shardFor(key).compute(key, std::forward<F>(fn));
+    }
+
+    //键存在时替换为fn(old)的返回值，转发给键所在的分片
+    template <typename F>
+    bool computeIfPresent(const K& key, F&& fn)
+    {
+        return shardFor(key).computeIfPresent(key, std::forward<F>(fn));
+    }
+
+    //合并写入，转发给键所在的分片
+    template <typename F>
+    V merge(const K& key, const V& value, F&& fn)
+    {
+        return shardFor(key).merge(key, value, std::forward<F>(fn));
+    }
+
+    //设置权重上限（字节数），与容量一样平均分给每个分片，0表示只按条目数限制
+    void setMaxWeight(size_t maxWeight)
+    {
+        size_t shardWeight = (maxWeight + shardNum - 1) / shardNum;
+        for(size_t i = 0; i < shardNum; ++i)
+        {
+            shards[i].cache.setMaxWeight(shardWeight);
+        }
+    }
+
+    //设置权重函数，每个分片各持有一份
+    template <typename W>
+    void setWeigher(const W& weigher)
+    {
+        for(size_t i = 0; i < shardNum; ++i)
+        {
+            shards[i].cache.setWeigher(weigher);
+        }
+    }
+
+    //当前总权重，逐个分片加锁读取后求和
+    size_t totalWeight()
+    {
+        size_t total = 0;
+        for(size_t i = 0; i < shardNum; ++i)
+        {
+            total += shards[i].cache.totalWeight();
+        }
+        return total;
+    }
+
+    //设置过期方式与默认存活时间，每个分片相同
+    template <typename Mode, typename Duration>
+    void setExpiry(Mode mode, Duration ttl)
+    {
+        for(size_t i = 0; i < shardNum; ++i)
+        {
+            shards[i].cache.setExpiry(mode, ttl);
+        }
+    }
+
+    //维护入口：逐个分片删除已到期的数据，返回删除的总条数
+    size_t cleanUp()
+    {
+        size_t expired = 0;
+        for(size_t i = 0; i < shardNum; ++i)
+        {
+            expired += shards[i].cache.cleanUp();
+        }
+        return expired;
+    }
+
+    //开启写回，所有分片共用同一个写回队列，由一个后台线程批量写回
+    template <typename Queue>
+    void setWriteBack(const Queue& queue)
+    {
+        for(size_t i = 0; i < shardNum; ++i)
+        {
+            shards[i].cache.setWriteBack(queue);
+        }
+    }
+
+    //逐个分片把脏数据交给写回队列并等待写回完成
+    void flush()
+    {
+        for(size_t i = 0; i < shardNum; ++i)
+        {
+            shards[i].cache.flush();
+        }
+    }
+
+    //批量获取：先按分片分组，每个分片整批转发一次，分片内只加一次锁
+    size_t getBatch(const K* keys, const size_t* order, size_t n, V* values, uint64_t* hitBits) override
+    {
+        if(shardNum == 1)return shards[0].cache.getBatch(keys, order, n, values, hitBits);
+
+        const BatchScratch& buf = groupByShard(keys, order, n);
+        const std::vector<size_t>& grouped = buf.grouped;
+        const std::vector<size_t>& offsets = buf.offsets;
+        size_t hits = 0;
+        for(size_t s = 0; s < shardNum; ++s)
+        {
+            size_t count = offsets[s + 1] - offsets[s];
+            if(count == 0)continue;
+            hits += shards[s].cache.getBatch(keys, grouped.data() + offsets[s], count, values, hitBits);
+        }
+        return hits;
+    }
+
+    //批量添加或更新：先按分片分组，每个分片整批转发一次
+    void putBatch(const K* keys, const V* values, const size_t* order, size_t n) override
+    {
+        if(shardNum == 1)
+        {
+            shards[0].cache.putBatch(keys, values, order, n);
+            return;
+        }
+
+        const BatchScratch& buf = groupByShard(keys, order, n);
+        const std::vector<size_t>& grouped = buf.grouped;
+        const std::vector<size_t>& offsets = buf.offsets;
+        for(size_t s = 0; s < shardNum; ++s)
+        {
+            size_t count = offsets[s + 1] - offsets[s];
+            if(count == 0)continue;
+            shards[s].cache.putBatch(keys, values, grouped.data() + offsets[s], count);
+        }
+    }
+};
+
+}
+#endif //MYCACHE_SHARDEDCACHE_H
@@ -0,0 +1,249 @@
+#ifndef MYCACHE_SIEVECACHE_H
+#define MYCACHE_SIEVECACHE_H
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+#include "CachePolicy.h"
+#include "ConcurrentIndex.h"
+#include "ShardedCache.h"
+
+namespace mycache {
+
+//SIEVE缓存（Zhang et al., NSDI'24）
+//数据按写入顺序排成FIFO队列，命中只置位访问位，从不移动节点：
+//  - 淘汰指针从最旧的数据向较新的数据移动，跳过并清除访问位为1的数据，淘汰第一个访问位为0的数据，
+//    然后停在原地等待下一次淘汰；走到最新端后回到最旧端
+//  - 与Clock不同，被跳过的数据留在原位而不是移到队尾，新数据与存活下来的旧数据自然分开
+//查找与ConcurrentClockCache相同，get完全不加锁：无锁探测ConcurrentIndex，按顺序锁读出键值，
+//访问位为0时以relaxed写入1；put、remove与淘汰由互斥锁串行化
+//顺序锁读取要求按字节拷贝键值，因此K和V必须是可平凡拷贝的类型
+template <typename K, typename V>
+class SieveCache : public CachePolicy<K, V>
+{
+    static_assert(std::is_trivially_copyable<K>::value, "SieveCache requires a trivially copyable key");
+    static_assert(std::is_trivially_copyable<V>::value, "SieveCache requires a trivially copyable value");
+
+private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    struct Slot : SeqlockEntry<K, V>
+    {
+        std::atomic<uint8_t> visited;   //访问位，读者用relaxed写入
+        uint32_t older;                 //FIFO中较旧的相邻槽位，只由持锁的写者访问
+        uint32_t newer;                 //FIFO中较新的相邻槽位
+        bool occupied;                  //是否存有数据
+        Slot() : visited(0), older(NIL), newer(NIL), occupied(false) {}
+    };
+
+    size_t capacity;                    //缓存容量
+    std::unique_ptr<Slot[]> slots;      //槽位数组
+    ConcurrentIndex<K> index;           //键到槽位的并发索引
+    std::vector<uint32_t> freeSlots;    //空闲槽位
+    uint32_t oldest;                    //FIFO最旧端
+    uint32_t newest;                    //FIFO最新端
+    uint32_t hand;                      //淘汰指针，NIL表示从最旧端开始
+    size_t size;                        //缓存条目数
+    std::mutex mtx;                     //写者互斥锁
+
+private:
+    size_t findEntry(const K& key, uint32_t hash) const
+    {
+        return index.find(key, hash, [this](size_t slot) -> const K& { return slots[slot].key; });
+    }
+    void pushNewest(uint32_t i)
+    {
+        Slot& slot = slots[i];
+        slot.older = newest;
+        slot.newer = NIL;
+        if(newest != NIL)slots[newest].newer = i;
+        else oldest = i;
+        newest = i;
+    }
+    //从FIFO中摘下槽位，淘汰指针指向它时移到较新的一侧
+    void unlink(uint32_t i)
+    {
+        Slot& slot = slots[i];
+        if(hand == i)hand = slot.newer;
+        if(slot.older != NIL)slots[slot.older].newer = slot.newer;
+        else oldest = slot.newer;
+        if(slot.newer != NIL)slots[slot.newer].older = slot.older;
+        else newest = slot.older;
+        slot.older = slot.newer = NIL;
+    }
+    //移动淘汰指针找到淘汰槽位并从FIFO与索引中删除，调用者持有锁
+    //读者会并发置位访问位，最多扫描两圈后强制淘汰当前槽位
+    uint32_t evict()
+    {
+        uint32_t i = hand != NIL ? hand : oldest;
+        for(size_t step = 0; step < 2 * size; ++step)
+        {
+            if(slots[i].visited.load(std::memory_order_relaxed) == 0)break;
+            slots[i].visited.store(0, std::memory_order_relaxed);
+            i = slots[i].newer != NIL ? slots[i].newer : oldest;
+        }
+        hand = i;
+        unlink(i);
+        index.erase(findEntry(slots[i].key, ConcurrentIndex<K>::hashOf(slots[i].key)));
+        slots[i].occupied = false;
+        --size;
+        return i;
+    }
+    //添加或更新缓存，调用者已持有锁；更新原地进行，不改变FIFO位置
+    void putLocked(const K& key, const V& value)
+    {
+        uint32_t hash = ConcurrentIndex<K>::hashOf(key);
+        size_t pos = findEntry(key, hash);
+        if(pos != ConcurrentIndex<K>::NPOS)
+        {
+            Slot& slot = slots[index.slotAt(pos)];
+            slot.write(key, value);
+            slot.visited.store(1, std::memory_order_relaxed);
+            return;
+        }
+
+        uint32_t i;
+        if(size < capacity)
+        {
+            i = freeSlots.back();
+            freeSlots.pop_back();
+        }
+        else
+        {
+            i = evict();
+        }
+        Slot& slot = slots[i];
+        slot.write(key, value);
+        slot.occupied = true;
+        slot.visited.store(0, std::memory_order_relaxed);
+        pushNewest(i);
+        index.insert(hash, i);
+        ++size;
+    }
+
+public:
+    explicit SieveCache(size_t n)
+    : capacity(n)
+    , index(n)
+    , oldest(NIL)
+    , newest(NIL)
+    , hand(NIL)
+    , size(0)
+    {
+        assert(capacity < NIL);
+        slots.reset(new Slot[capacity > 0 ? capacity : 1]);
+        freeSlots.reserve(capacity);
+        for(size_t i = capacity; i > 0; --i)
+        {
+            freeSlots.push_back(static_cast<uint32_t>(i - 1));
+        }
+    }
+    ~SieveCache() override = default;
+
+    //无锁读取：探测索引，按顺序锁读出槽位，访问位为0时置位
+    bool get(const K& key, V& value) override
+    {
+        if(capacity <= 0)return false;
+
+        return index.probe(ConcurrentIndex<K>::hashOf(key), [&](size_t i)
+        {
+            Slot& slot = slots[i];
+            if(!slot.read(key, value))return false;
+            if(slot.visited.load(std::memory_order_relaxed) == 0)slot.visited.store(1, std::memory_order_relaxed);
+            return true;
+        });
+    }
+
+    V get(const K& key) override
+    {
+        V value{};
+        get(key, value);
+        return value;
+    }
+
+    void put(const K& key, const V& value) override
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        putLocked(key, value);
+    }
+
+    //与其他策略接口一致的访问方式：值可平凡拷贝，按顺序锁读出副本后调用fn
+    template <typename F>
+    bool visit(const K& key, F&& fn)
+    {
+        V value;
+        if(!get(key, value))return false;
+        fn(static_cast<const V&>(value));
+        return true;
+    }
+
+    //与其他策略接口一致的原地构造：值可平凡拷贝，构造后按值写入
+    template <typename KK, typename... Args>
+    void emplace(KK&& key, Args&&... args)
+    {
+        put(K(std::forward<KK>(key)), V(std::forward<Args>(args)...));
+    }
+
+    //批量写入，整批只加一次写者锁；批量读取沿用逐个无锁读取的默认实现
+    void putBatch(const K* keys, const V* values, const size_t* order, size_t n) override
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            putLocked(keys[i], values[i]);
+        }
+    }
+
+    void remove(const K& key)
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t pos = findEntry(key, ConcurrentIndex<K>::hashOf(key));
+        if(pos == ConcurrentIndex<K>::NPOS)return;
+        uint32_t i = static_cast<uint32_t>(index.slotAt(pos));
+        index.erase(pos);
+        unlink(i);
+        slots[i].occupied = false;
+        freeSlots.push_back(i);
+        --size;
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        index.clear();
+        freeSlots.clear();
+        for(size_t i = capacity; i > 0; --i)
+        {
+            slots[i - 1].occupied = false;
+            slots[i - 1].older = slots[i - 1].newer = NIL;
+            freeSlots.push_back(static_cast<uint32_t>(i - 1));
+        }
+        oldest = newest = hand = NIL;
+        size = 0;
+    }
+};
+
+//分片SIEVE缓存，各分片独立加锁，分片逻辑见ShardedCache
+template <typename K, typename V>
+class HashSieveCache : public ShardedCache<SieveCache<K, V>>
+{
+public:
+    //n：总容量；sliceNum：切片数量，向上取整为2的幂
+    HashSieveCache(size_t n, int sliceNum)
+    : ShardedCache<SieveCache<K, V>>(n, sliceNum > 0 ? static_cast<size_t>(sliceNum) : 1) {}
+};
+
+}
+#endif //MYCACHE_SIEVECACHE_H
@@ -0,0 +1,156 @@
+#ifndef MYCACHE_SINGLEFLIGHT_H
+#define MYCACHE_SINGLEFLIGHT_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "FlatHashMap.h"
+#include "HashUtil.h"
+
+namespace mycache {
+
+//合并同一个键的并发加载
+//同一时刻对同一个键只有第一个调用者（领头者）执行加载，其余调用者等待并共享领头者的结果，
+//加载抛出的异常同样传给所有等待者；加载结束后记录立即删除，之后的调用重新加载
+template <typename K, typename V, typename Hash = std::hash<K>, typename KeyEqual = std::equal_to<K>>
+class SingleFlight
+{
+private:
+    //一次进行中的加载
+    struct Call
+    {
+        std::mutex mtx;
+        std::condition_variable cv;
+        bool done = false;              //加载是否已结束
+        V value{};                      //加载结果
+        std::exception_ptr error;       //加载抛出的异常
+    };
+
+    std::mutex mtx;                                 //保护calls
+    FlatHashMap<K, std::shared_ptr<Call>, Hash, KeyEqual> calls;    //键到进行中加载的映射
+
+public:
+    SingleFlight() = default;
+    SingleFlight(const SingleFlight&) = delete;
+    SingleFlight& operator=(const SingleFlight&) = delete;
+
+    //执行或等待key的加载并返回结果，fn只会在领头者线程中调用
+    template <typename F>
+    V run(const K& key, F&& fn)
+    {
+        std::shared_ptr<Call> call;
+        bool leader = false;
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            auto it = calls.find(key);
+            if(it != calls.end())
+            {
+                call = it->second;
+            }
+            else
+            {
+                call = std::make_shared<Call>();
+                calls.emplace(key, call);
+                leader = true;
+            }
+        }
+
+        if(!leader)
+        {
+            std::unique_lock<std::mutex> lock(call->mtx);
+            call->cv.wait(lock, [&call] { return call->done; });
+            if(call->error)std::rethrow_exception(call->error);
+            return call->value;
+        }
+
+        try
+        {
+            call->value = fn();
+        }
+        catch(...)
+        {
+            call->error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            calls.erase(key);
+        }
+        {
+            std::lock_guard<std::mutex> lock(call->mtx);
+            call->done = true;
+        }
+        call->cv.notify_all();
+        if(call->error)std::rethrow_exception(call->error);
+        return call->value;
+    }
+
+    //进行中的加载数量
+    size_t inFlight()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return calls.size();
+    }
+};
+
+//CachePolicy::getOrLoad使用的共享合并表
+//缓存对象本身不保存合并加载的状态：同一种K、V的全部缓存实例（包括每个分片）共用一张表，键为(缓存实例地址, 键)，
+//表按哈希分成STRIPES段各自加锁，第一次调用getOrLoad时才构造，不调用getOrLoad的缓存没有任何开销
+template <typename K, typename V>
+class SharedLoadGroup
+{
+private:
+    struct OwnedKey
+    {
+        const void* owner;      //发起加载的缓存实例
+        K key;
+    };
+    //(实例, 键)混合后的64位哈希
+    static uint64_t mixedHash(const OwnedKey& k)
+    {
+        uint64_t h = static_cast<uint64_t>(std::hash<K>()(k.key));
+        return hashMix(h ^ static_cast<uint64_t>(reinterpret_cast<uintptr_t>(k.owner)));
+    }
+    struct OwnedKeyHash
+    {
+        size_t operator()(const OwnedKey& k) const
+        {
+            return static_cast<size_t>(mixedHash(k));
+        }
+    };
+    struct OwnedKeyEqual
+    {
+        bool operator()(const OwnedKey& a, const OwnedKey& b) const
+        {
+            return a.owner == b.owner && a.key == b.key;
+        }
+    };
+
+    static constexpr size_t STRIPES = 16;
+
+    //按缓存行对齐，相邻段的互斥锁不落在同一缓存行上
+    struct alignas(64) Stripe
+    {
+        SingleFlight<OwnedKey, V, OwnedKeyHash, OwnedKeyEqual> group;
+    };
+
+public:
+    //以owner为所属缓存执行或等待key的加载，语义同SingleFlight::run
+    template <typename F>
+    static V run(const void* owner, const K& key, F&& fn)
+    {
+        static Stripe stripes[STRIPES];
+        OwnedKey ownedKey{owner, key};
+        //段号在收窄为size_t之前取64位哈希的高4位，size_t只有32位时同样分散到全部段；段内哈希表会对哈希值再混合一次
+        size_t stripe = static_cast<size_t>(mixedHash(ownedKey) >> 60) & (STRIPES - 1);
+        return stripes[stripe].group.run(ownedKey, std::forward<F>(fn));
+    }
+};
+
+}
+#endif //MYCACHE_SINGLEFLIGHT_H
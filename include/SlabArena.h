@@ -0,0 +1,128 @@
+#ifndef MYCACHE_SLABARENA_H
+#define MYCACHE_SLABARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <vector>
+#include <utility>
+
+namespace mycache {
+
+//按块大小分级的slab内存池
+//每个缓存（或分片）持有一个，只在缓存自身的锁内使用，因此内部不加锁
+//释放的块挂回对应规格的空闲链表，缓存写满后淘汰与插入循环复用这些块，不再向系统申请内存
+class SlabArena
+{
+private:
+    static constexpr size_t BLOCK_ALIGN = alignof(std::max_align_t);    //块对齐粒度
+    static constexpr size_t CLASS_NUM = 32;                             //块规格数量
+    static constexpr size_t MAX_BLOCK = BLOCK_ALIGN * CLASS_NUM;        //池内管理的最大块
+    static constexpr size_t SLAB_BYTES = 16 * 1024;                     //每次向系统申请的slab大小
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    FreeBlock* freeLists[CLASS_NUM];                        //各规格的空闲块链表
+    std::vector<std::unique_ptr<unsigned char[]>> slabs;    //已申请的slab，随内存池一起释放
+
+private:
+    //计算块大小对应的规格下标
+    static size_t classIndex(size_t bytes)
+    {
+        return (bytes + BLOCK_ALIGN - 1) / BLOCK_ALIGN - 1;
+    }
+    //申请新的slab并切分成指定规格的空闲块
+    void refill(size_t index)
+    {
+        size_t blockSize = (index + 1) * BLOCK_ALIGN;
+        size_t blockNum = SLAB_BYTES / blockSize;
+        slabs.emplace_back(new unsigned char[blockSize * blockNum]);
+        unsigned char* slab = slabs.back().get();
+        for(size_t i = blockNum; i > 0; --i)
+        {
+            FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + (i - 1) * blockSize);
+            block->next = freeLists[index];
+            freeLists[index] = block;
+        }
+    }
+
+public:
+    SlabArena()
+    {
+        for(size_t i = 0; i < CLASS_NUM; ++i)
+        {
+            freeLists[i] = nullptr;
+        }
+    }
+    SlabArena(const SlabArena&) = delete;
+    SlabArena& operator=(const SlabArena&) = delete;
+
+    //申请内存块，超过最大规格的请求直接交给全局operator new
+    void* allocate(size_t bytes)
+    {
+        if(bytes == 0)bytes = 1;
+        if(bytes > MAX_BLOCK)
+        {
+            return ::operator new(bytes);
+        }
+        size_t index = classIndex(bytes);
+        if(freeLists[index] == nullptr)
+        {
+            refill(index);
+        }
+        FreeBlock* block = freeLists[index];
+        freeLists[index] = block->next;
+        return block;
+    }
+
+    //归还内存块，bytes必须与申请时一致
+    void deallocate(void* p, size_t bytes)
+    {
+        if(p == nullptr)return;
+        if(bytes == 0)bytes = 1;
+        if(bytes > MAX_BLOCK)
+        {
+            ::operator delete(p);
+            return;
+        }
+        size_t index = classIndex(bytes);
+        FreeBlock* block = static_cast<FreeBlock*>(p);
+        block->next = freeLists[index];
+        freeLists[index] = block;
+    }
+
+    //在池中构造对象
+    template <typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+        static_assert(alignof(T) <= BLOCK_ALIGN, "over-aligned type is not supported by SlabArena");
+        void* p = allocate(sizeof(T));
+        try
+        {
+            return new (p) T(std::forward<Args>(args)...);
+        }
+        catch(...)
+        {
+            deallocate(p, sizeof(T));
+            throw;
+        }
+    }
+
+    //析构对象并归还内存块
+    template <typename T>
+    void destroy(T* p)
+    {
+        if(p == nullptr)return;
+        p->~T();
+        deallocate(p, sizeof(T));
+    }
+
+    //已申请的slab数量，用于观察内存池是否还在增长
+    size_t slabCount() const { return slabs.size(); }
+};
+
+}
+#endif //MYCACHE_SLABARENA_H
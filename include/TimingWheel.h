@@ -0,0 +1,223 @@
+#ifndef MYCACHE_TIMINGWHEEL_H
+#define MYCACHE_TIMINGWHEEL_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace mycache {
+
+//过期方式
+enum class ExpireMode
+{
+    AfterWrite,     //写入后经过ttl过期，读取不续期
+    AfterAccess     //最后一次读写后经过ttl过期，每次访问都续期
+};
+
+//时间轮上的定时节点，缓存节点继承它，侵入式地挂在时间轮的槽位链表上，不额外分配内存
+struct TimerNode
+{
+    static constexpr uint32_t NO_SLOT = UINT32_MAX;
+
+    TimerNode* timerPrev = nullptr;
+    TimerNode* timerNext = nullptr;
+    uint64_t expireTick = 0;        //到期的刻度
+    uint32_t ttlTicks = 0;          //存活的刻度数，0表示不过期
+    uint32_t timerSlot = NO_SLOT;   //所在槽位（层号*每层槽数+槽下标），NO_SLOT表示不在时间轮中
+};
+
+//分层时间轮
+//4层，每层256个槽，第l层一个槽覆盖256^l个刻度；节点按距到期的刻度数放入对应层，
+//低层转完一圈时把上一层当前槽的节点重新分配到低层（级联），第0层的槽到点即过期
+//  - 安排、取消、续期都是O(1)；每个节点最多级联层数次，过期处理均摊O(1)
+//  - advance推进时，低层全空就直接跳到下一次级联的刻度，长时间空闲后推进也不逐刻度扫描
+//  - 超过4层跨度的存活时间先放在最高层，级联到第0层时尚未到期则重新安排
+//与SlabArena一样只在所属缓存的锁内使用，内部不加锁
+class TimingWheel
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+private:
+    static constexpr uint32_t LEVEL_BITS = 8;
+    static constexpr uint32_t SLOTS = 1u << LEVEL_BITS;         //每层槽数
+    static constexpr uint32_t SLOT_MASK = SLOTS - 1;
+    static constexpr uint32_t LEVELS = 4;                       //层数
+    static constexpr uint64_t MAX_SPAN = uint64_t(1) << (LEVEL_BITS * LEVELS);
+
+    Clock::time_point start;            //刻度0对应的时间
+    Clock::duration tick;               //每个刻度的时长
+    uint64_t currentTick;               //下一个待处理的刻度
+    size_t count;                       //时间轮中的节点数
+    size_t levelCount[LEVELS];          //各层的节点数，用于跳过空层
+    TimerNode* slots[LEVELS * SLOTS];   //各槽位的链表头
+
+private:
+    void link(TimerNode* node, uint32_t slot)
+    {
+        node->timerSlot = slot;
+        node->timerPrev = nullptr;
+        node->timerNext = slots[slot];
+        if(slots[slot])slots[slot]->timerPrev = node;
+        slots[slot] = node;
+        ++count;
+        ++levelCount[slot / SLOTS];
+    }
+    void unlink(TimerNode* node)
+    {
+        uint32_t slot = node->timerSlot;
+        if(node->timerPrev)node->timerPrev->timerNext = node->timerNext;
+        else slots[slot] = node->timerNext;
+        if(node->timerNext)node->timerNext->timerPrev = node->timerPrev;
+        node->timerPrev = node->timerNext = nullptr;
+        node->timerSlot = TimerNode::NO_SLOT;
+        --count;
+        --levelCount[slot / SLOTS];
+    }
+    //按距到期的刻度数放入对应的层与槽
+    void insert(TimerNode* node)
+    {
+        uint64_t delta = node->expireTick > currentTick ? node->expireTick - currentTick : 0;
+        if(delta >= MAX_SPAN)delta = MAX_SPAN - 1;
+        uint64_t at = currentTick + delta;
+        uint32_t level = 0;
+        while(level + 1 < LEVELS && delta >= (uint64_t(1) << (LEVEL_BITS * (level + 1))))++level;
+        link(node, level * SLOTS + static_cast<uint32_t>((at >> (LEVEL_BITS * level)) & SLOT_MASK));
+    }
+    //摘下整个槽的链表，逐个节点断开后交给fn
+    template <typename F>
+    void drain(uint32_t slot, F&& fn)
+    {
+        TimerNode* node = slots[slot];
+        while(node)
+        {
+            TimerNode* next = node->timerNext;
+            unlink(node);
+            fn(node);
+            node = next;
+        }
+    }
+    //刻度tick处低层转完一圈，从高到低把上层当前槽的节点重新分配
+    void cascade(uint64_t at)
+    {
+        for(uint32_t level = LEVELS - 1; level > 0; --level)
+        {
+            if((at & ((uint64_t(1) << (LEVEL_BITS * level)) - 1)) != 0)continue;
+            uint32_t slot = level * SLOTS + static_cast<uint32_t>((at >> (LEVEL_BITS * level)) & SLOT_MASK);
+            drain(slot, [this](TimerNode* node) { insert(node); });
+        }
+    }
+
+public:
+    //tickDuration：刻度时长，过期时间按刻度向上取整
+    explicit TimingWheel(Clock::duration tickDuration = std::chrono::milliseconds(1))
+    : start(Clock::now())
+    , tick(tickDuration)
+    , currentTick(0)
+    , count(0)
+    {
+        for(uint32_t i = 0; i < LEVELS; ++i)levelCount[i] = 0;
+        for(uint32_t i = 0; i < LEVELS * SLOTS; ++i)slots[i] = nullptr;
+    }
+    TimingWheel(const TimingWheel&) = delete;
+    TimingWheel& operator=(const TimingWheel&) = delete;
+
+    //当前时间对应的刻度
+    uint64_t now() const
+    {
+        return static_cast<uint64_t>((Clock::now() - start) / tick);
+    }
+    //把存活时间换算成刻度数，向上取整；0表示不过期
+    template <typename Rep, typename Period>
+    uint32_t toTicks(std::chrono::duration<Rep, Period> ttl) const
+    {
+        if(ttl <= ttl.zero())return 0;
+        auto d = std::chrono::duration_cast<Clock::duration>(ttl);
+        uint64_t ticks = static_cast<uint64_t>((d + tick - Clock::duration(1)) / tick);
+        if(ticks == 0)ticks = 1;
+        return ticks >= UINT32_MAX ? UINT32_MAX - 1 : static_cast<uint32_t>(ticks);
+    }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    //从现在起经过ttl个刻度后过期，节点已在时间轮中时重新安排；ttl为0时取消过期
+    void schedule(TimerNode* node, uint32_t ttl)
+    {
+        cancel(node);
+        node->ttlTicks = ttl;
+        if(ttl == 0)return;
+        uint64_t nowTick = now();
+        //时间轮为空时没有推进过，直接追上当前刻度
+        if(count == 0 && currentTick < nowTick)currentTick = nowTick;
+        node->expireTick = nowTick + ttl;
+        insert(node);
+    }
+    //按节点自身的存活时间重新计时，用于访问续期与写入后重新计时
+    void restart(TimerNode* node)
+    {
+        if(node->ttlTicks != 0)schedule(node, node->ttlTicks);
+    }
+    //从时间轮中移除节点，不在时间轮中时什么也不做
+    void cancel(TimerNode* node)
+    {
+        if(node->timerSlot != TimerNode::NO_SLOT)unlink(node);
+    }
+
+    //处理到nowTick为止（含）到期的节点：节点先从时间轮中移除，再以onExpire(TimerNode*)通知所属缓存删除
+    //返回过期的节点数
+    template <typename F>
+    size_t advance(uint64_t nowTick, F&& onExpire)
+    {
+        size_t expired = 0;
+        while(currentTick <= nowTick)
+        {
+            if(count == 0)
+            {
+                currentTick = nowTick + 1;
+                break;
+            }
+            //低层全空时没有要过期或级联的节点，跳到下一次级联的刻度
+            uint32_t level = 0;
+            while(levelCount[level] == 0)++level;
+            if(level > 0)
+            {
+                uint64_t span = uint64_t(1) << (LEVEL_BITS * level);
+                uint64_t next = (currentTick + span - 1) & ~(span - 1);
+                if(next > nowTick)
+                {
+                    currentTick = nowTick + 1;
+                    break;
+                }
+                currentTick = next;
+            }
+            cascade(currentTick);
+            uint64_t at = currentTick;
+            drain(static_cast<uint32_t>(at & SLOT_MASK), [&](TimerNode* node)
+            {
+                //存活时间超过时间轮跨度的节点提前落到第0层，尚未到期则重新安排
+                if(node->expireTick > at)insert(node);
+                else
+                {
+                    ++expired;
+                    onExpire(node);
+                }
+            });
+            ++currentTick;
+        }
+        return expired;
+    }
+
+    //清空时间轮，所有节点恢复为不在时间轮中的状态
+    void clear()
+    {
+        for(uint32_t i = 0; i < LEVELS * SLOTS; ++i)
+        {
+            drain(i, [](TimerNode* node) { node->ttlTicks = 0; });
+        }
+    }
+};
+
+}
+#endif //MYCACHE_TIMINGWHEEL_H
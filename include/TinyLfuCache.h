@@ -0,0 +1,406 @@
+#ifndef MYCACHE_TINYLFUCACHE_H
+#define MYCACHE_TINYLFUCACHE_H
+
+#include <algorithm>
+#include <mutex>
+#include <utility>
+
+#include "CachePolicy.h"
+#include "FrequencySketch.h"
+#include "ShardedCache.h"
+#include "SlabArena.h"
+#include "FlatHashMap.h"
+
+namespace mycache {
+
+//W-TinyLFU中节点所在的区域
+enum class TinyLfuListId
+{
+    Window,     //准入窗口：新数据先进入这里，按LRU淘汰
+    Probation,  //主区的试用段：刚通过准入或从保护段降级的数据
+    Protected   //主区的保护段：在试用段中再次被访问的数据
+};
+
+template <typename K, typename V>
+struct TinyLfuNode
+{
+    K key;
+    V value;
+    TinyLfuListId list;     //所在区域
+    TinyLfuNode* prev;
+    TinyLfuNode* next;
+    template <typename KK, typename... Args>
+    explicit TinyLfuNode(KK&& k, Args&&... args)
+    : key(std::forward<KK>(k)), value(std::forward<Args>(args)...), list(TinyLfuListId::Window), prev(nullptr), next(nullptr) {}
+};
+
+//W-TinyLFU缓存（Einziger & Friedman，Caffeine的默认策略）
+//  - 容量的1%作为LRU准入窗口（至少1个条目，大小固定），其余为分段LRU主区，保护段占主区的80%
+//  - 窗口淘汰出的候选者与主区的淘汰者比较频率草图中的估计访问次数，候选者严格更高才替换淘汰者，否则丢弃候选者
+//  - 频率草图每个条目约8字节且不保存键，代替ARC的幽灵节点记录历史：扫描与只访问一次的数据很难挤掉热点
+//三个区域共用一张哈希索引，每次操作只加一次锁
+template <typename K, typename V>
+class TinyLfuCache : public CachePolicy<K, V>
+{
+public:
+    using NodeType = TinyLfuNode<K, V>;
+    using NodePtr = NodeType*;
+    using NodeMap = FlatHashMap<K, NodePtr>;
+
+private:
+    //侵入式双向链表，表头最久未使用，表尾最近使用
+    struct NodeList
+    {
+        NodePtr head = nullptr;
+        NodePtr tail = nullptr;
+        size_t size = 0;
+    };
+
+    size_t capacity;            //缓存容量
+    size_t windowCapacity;      //准入窗口的容量
+    size_t mainCapacity;        //主区的容量
+    size_t protectedCapacity;   //保护段的容量
+    std::mutex mtx;             //互斥锁
+    SlabArena arena;            //节点内存池
+    NodeMap nodeMap;            //键到节点的索引
+    NodeList lists[3];          //按TinyLfuListId排列的三个区域
+    FrequencySketch<K> sketch;  //访问频率草图
+
+private:
+    NodeList& listOf(TinyLfuListId id) { return lists[static_cast<int>(id)]; }
+
+    void pushBack(TinyLfuListId id, NodePtr node)
+    {
+        NodeList& list = listOf(id);
+        node->list = id;
+        node->next = nullptr;
+        node->prev = list.tail;
+        if(list.tail)list.tail->next = node;
+        else list.head = node;
+        list.tail = node;
+        list.size++;
+    }
+    void unlink(NodePtr node)
+    {
+        NodeList& list = listOf(node->list);
+        if(node->prev)node->prev->next = node->next;
+        else list.head = node->next;
+        if(node->next)node->next->prev = node->prev;
+        else list.tail = node->prev;
+        node->prev = nullptr;
+        node->next = nullptr;
+        list.size--;
+    }
+    void moveTo(TinyLfuListId id, NodePtr node)
+    {
+        unlink(node);
+        pushBack(id, node);
+    }
+    //删除节点，同时移出索引
+    void destroyNode(NodePtr node)
+    {
+        unlink(node);
+        nodeMap.erase(node->key);
+        arena.destroy(node);
+    }
+    //命中后调整位置：窗口内移到尾部，试用段晋升到保护段，保护段超出容量时把最久未使用的降回试用段
+    void onHit(NodePtr node)
+    {
+        switch(node->list)
+        {
+        case TinyLfuListId::Window:
+            moveTo(TinyLfuListId::Window, node);
+            break;
+        case TinyLfuListId::Probation:
+            moveTo(TinyLfuListId::Protected, node);
+            if(listOf(TinyLfuListId::Protected).size > protectedCapacity)
+            {
+                moveTo(TinyLfuListId::Probation, listOf(TinyLfuListId::Protected).head);
+            }
+            break;
+        case TinyLfuListId::Protected:
+            moveTo(TinyLfuListId::Protected, node);
+            break;
+        }
+    }
+    //窗口超出容量时把最久未使用的数据交给主区准入
+    void evictFromWindow()
+    {
+        while(listOf(TinyLfuListId::Window).size > windowCapacity)
+        {
+            NodePtr candidate = listOf(TinyLfuListId::Window).head;
+            size_t mainSize = listOf(TinyLfuListId::Probation).size + listOf(TinyLfuListId::Protected).size;
+            if(mainSize < mainCapacity)
+            {
+                moveTo(TinyLfuListId::Probation, candidate);
+                continue;
+            }
+            //主区已满：淘汰者优先取试用段的表头，试用段为空时取保护段的表头
+            NodePtr victim = listOf(TinyLfuListId::Probation).head;
+            if(victim == nullptr)victim = listOf(TinyLfuListId::Protected).head;
+            if(victim != nullptr && sketch.frequency(candidate->key) > sketch.frequency(victim->key))
+            {
+                destroyNode(victim);
+                moveTo(TinyLfuListId::Probation, candidate);
+            }
+            else
+            {
+                destroyNode(candidate);
+            }
+        }
+    }
+    //新的键放入窗口尾部，返回新节点
+    template <typename KK, typename... Args>
+    NodePtr addNewNode(KK&& key, Args&&... args)
+    {
+        NodePtr node = arena.create<NodeType>(std::forward<KK>(key), std::forward<Args>(args)...);
+        nodeMap.emplace(node->key, node);
+        pushBack(TinyLfuListId::Window, node);
+        evictFromWindow();
+        return node;
+    }
+    //添加或更新缓存，调用者已持有锁
+    template <typename KK, typename... Args>
+    void putLocked(KK&& key, Args&&... args)
+    {
+        sketch.increment(key);
+        auto it = nodeMap.find(key);
+        if(it != nodeMap.end())
+        {
+            NodePtr node = it->second;
+            node->value = V(std::forward<Args>(args)...);
+            onHit(node);
+            return;
+        }
+        addNewNode(std::forward<KK>(key), std::forward<Args>(args)...);
+    }
+    //读-改-写缓存，调用者已持有锁：fn以旧值的指针计算新值，键不存在时传入nullptr
+    template <typename F>
+    V computeLocked(const K& key, F&& fn)
+    {
+        sketch.increment(key);
+        auto it = nodeMap.find(key);
+        if(it != nodeMap.end())
+        {
+            NodePtr node = it->second;
+            node->value = fn(static_cast<const V*>(&node->value));
+            onHit(node);
+            return node->value;
+        }
+        V value = fn(static_cast<const V*>(nullptr));
+        addNewNode(key, value);
+        return value;
+    }
+    //获取缓存，调用者已持有锁；未命中同样计入频率，之后写入时候选者已有历史
+    bool getLocked(const K& key, V& value)
+    {
+        sketch.increment(key);
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end())return false;
+        NodePtr node = it->second;
+        value = node->value;
+        onHit(node);
+        return true;
+    }
+    //释放全部节点
+    void destroyAll()
+    {
+        for(auto it = nodeMap.begin(); it != nodeMap.end(); ++it)
+        {
+            arena.destroy(it->second);
+        }
+        nodeMap.clear();
+        for(NodeList& list : lists)
+        {
+            list = NodeList();
+        }
+    }
+
+public:
+    explicit TinyLfuCache(size_t n)
+    : capacity(n)
+    , windowCapacity(std::max<size_t>(n / 100, 1))
+    , mainCapacity(n > windowCapacity ? n - windowCapacity : 0)
+    , protectedCapacity(mainCapacity * 4 / 5)
+    , sketch(n)
+    {
+        nodeMap.reserve(capacity + 1);
+    }
+
+    ~TinyLfuCache() override
+    {
+        destroyAll();
+    }
+
+    void put(const K& key, const V& value) override
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        putLocked(key, value);
+    }
+
+    void put(K&& key, V&& value) override
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        putLocked(std::move(key), std::move(value));
+    }
+
+    //写入从存储加载的数据：键不存在时插入，已存在时保留缓存中的值
+    void putLoaded(const K& key, const V& value) override
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        if(nodeMap.contains(key))return;
+        addNewNode(key, value);
+    }
+
+    //原地构造缓存数据：args直接用于构造值，键已存在时以新构造的值替换旧值
+    template <typename KK, typename... Args>
+    void emplace(KK&& key, Args&&... args)
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        putLocked(std::forward<KK>(key), std::forward<Args>(args)...);
+    }
+
+    bool get(const K& key, V& value) override
+    {
+        if(capacity <= 0)return false;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        return getLocked(key, value);
+    }
+
+    V get(const K& key) override
+    {
+        V value{};
+        get(key, value);
+        return value;
+    }
+
+    //原地访问缓存值：命中时在持锁期间以const V&调用fn，不拷贝值
+    //fn返回后引用即失效，fn内不能再访问同一个缓存
+    template <typename F>
+    bool visit(const K& key, F&& fn)
+    {
+        if(capacity <= 0)return false;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        sketch.increment(key);
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end())return false;
+        NodePtr node = it->second;
+        onHit(node);
+        fn(static_cast<const V&>(node->value));
+        return true;
+    }
+
+    //原子地读-改-写：fn(const V* old)返回新值，键不存在时old为nullptr，新值写入缓存并返回
+    //查找、计算与写入在同一次加锁内完成；fn在持锁期间调用，fn内不能再访问同一个缓存
+    template <typename F>
+    V compute(const K& key, F&& fn)
+    {
+        if(capacity <= 0)return fn(static_cast<const V*>(nullptr));
+
+        std::lock_guard<std::mutex> lock(mtx);
+        return computeLocked(key, std::forward<F>(fn));
+    }
+
+    //键存在时以fn(const V& old)的返回值替换旧值，不存在时不写入，返回键是否存在
+    template <typename F>
+    bool computeIfPresent(const K& key, F&& fn)
+    {
+        if(capacity <= 0)return false;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end())return false;
+        sketch.increment(key);
+        NodePtr node = it->second;
+        node->value = fn(static_cast<const V&>(node->value));
+        onHit(node);
+        return true;
+    }
+
+    //合并写入：键不存在时写入value，存在时写入fn(old, value)，返回写入的新值，适合计数器与聚合值
+    template <typename F>
+    V merge(const K& key, const V& value, F&& fn)
+    {
+        return compute(key, [&](const V* old) -> V { return old ? fn(*old, value) : value; });
+    }
+
+    //批量获取，整批只加一次锁
+    size_t getBatch(const K* keys, const size_t* order, size_t n, V* values, uint64_t* hitBits) override
+    {
+        if(capacity <= 0)return 0;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        size_t hits = 0;
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            if(getLocked(keys[i], values[i]))
+            {
+                hitBits[i / 64] |= uint64_t(1) << (i % 64);
+                ++hits;
+            }
+        }
+        return hits;
+    }
+
+    //批量添加或更新，整批只加一次锁
+    void putBatch(const K* keys, const V* values, const size_t* order, size_t n) override
+    {
+        if(capacity <= 0)return;
+
+        std::lock_guard<std::mutex> lock(mtx);
+        for(size_t j = 0; j < n; ++j)
+        {
+            size_t i = order ? order[j] : j;
+            putLocked(keys[i], values[i]);
+        }
+    }
+
+    //删除缓存数据，频率草图中的历史保留
+    bool remove(const K& key)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = nodeMap.find(key);
+        if(it == nodeMap.end())return false;
+        destroyNode(it->second);
+        return true;
+    }
+
+    //清空缓存与频率草图
+    void purge()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        destroyAll();
+        sketch.clear();
+    }
+
+    //频率草图占用的字节数
+    size_t sketchBytes()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return sketch.bytes();
+    }
+};
+
+//分片W-TinyLFU，每个分片各有一个窗口、主区与按分片容量建立的频率草图
+template <typename K, typename V>
+class HashTinyLfuCache : public ShardedCache<TinyLfuCache<K, V>>
+{
+public:
+    //n：总容量；sliceNum：切片数量，向上取整为2的幂
+    HashTinyLfuCache(size_t n, int sliceNum)
+    : ShardedCache<TinyLfuCache<K, V>>(n, sliceNum > 0 ? static_cast<size_t>(sliceNum) : 1) {}
+};
+
+}
+#endif //MYCACHE_TINYLFUCACHE_H
@@ -0,0 +1,246 @@
+#ifndef MYCACHE_WRITEBEHIND_H
+#define MYCACHE_WRITEBEHIND_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "BackingStore.h"
+#include "FlatHashMap.h"
+
+namespace mycache {
+
+//脏数据异步写回队列
+//缓存淘汰脏数据时只把键值放入队列，后台线程按批调用BackingStore::storeMany写回，淘汰路径上不做I/O
+//  - 合并：同一个键在写回前多次入队只保留最新的值
+//  - 有界：入队从不阻塞（调用者通常持有缓存锁），待写回的键达到上限后，写入方在释放缓存锁后由throttle阻塞，
+//    直到后台线程取走一批；上限是软上限，持锁期间的淘汰与过期可以暂时超出
+//  - 待写回的键达到一批的大小，或距上次写回超过flushInterval时写回
+//  - 写回前与写回中的数据可以用find查到，读穿透时不会读到存储里的旧值
+//多个缓存或同一缓存的多个分片可以共用一个队列
+template <typename K, typename V>
+class WriteBehindQueue
+{
+private:
+    std::shared_ptr<BackingStore<K, V>> store;  //写回的目标存储
+    size_t maxPending;                          //待写回的键数上限
+    size_t batchSize;                           //每次storeMany写回的最大条数
+    std::chrono::milliseconds flushInterval;    //数据不足一批时的最长等待时间
+
+    std::mutex mtx;
+    std::condition_variable wakeFlusher;        //通知后台线程有数据或需要立即写回
+    std::condition_variable notFull;            //通知入队方队列有空位
+    std::condition_variable drained;            //通知flush调用者一轮写回结束
+
+    std::vector<K> pendingKeys;                 //待写回的键
+    std::vector<V> pendingValues;               //待写回的值，与pendingKeys一一对应
+    FlatHashMap<K, size_t> pendingIndex;        //键在pending中的下标，用于合并
+    std::vector<K> flushingKeys;                //后台线程正在写回的一批
+    std::vector<V> flushingValues;
+    FlatHashMap<K, size_t> flushingIndex;
+
+    bool flushNow;                              //flush要求立即写回
+    size_t writtenNum;                          //已写回的条数
+    size_t batchNum;                            //storeMany调用次数
+    size_t failedNum;                           //写回抛出异常而丢弃的条数
+    bool stopping;
+    std::thread flusher;
+
+private:
+    //后台线程：攒够一批或等待超时后，取走全部待写回数据，在锁外按批写回
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        while(true)
+        {
+            wakeFlusher.wait_for(lock, flushInterval, [this]
+            {
+                return stopping || flushNow || pendingKeys.size() >= batchSize;
+            });
+            flushNow = false;
+            if(pendingKeys.empty())
+            {
+                drained.notify_all();
+                if(stopping)break;
+                continue;
+            }
+            flushingKeys.swap(pendingKeys);
+            flushingValues.swap(pendingValues);
+            std::swap(flushingIndex, pendingIndex);
+            notFull.notify_all();
+
+            lock.unlock();
+            size_t failed = 0;
+            size_t batches = 0;
+            for(size_t begin = 0; begin < flushingKeys.size(); begin += batchSize)
+            {
+                size_t n = std::min(batchSize, flushingKeys.size() - begin);
+                try
+                {
+                    store->storeMany(flushingKeys.data() + begin, flushingValues.data() + begin, n);
+                }
+                catch(...)
+                {
+                    failed += n;
+                }
+                ++batches;
+            }
+            lock.lock();
+
+            writtenNum += flushingKeys.size() - failed;
+            failedNum += failed;
+            batchNum += batches;
+            flushingKeys.clear();
+            flushingValues.clear();
+            flushingIndex.clear();
+            drained.notify_all();
+        }
+    }
+
+public:
+    //store：写回的目标存储；maxPending：待写回的键数上限；batchSize：每批最大条数；flushInterval：不足一批时的最长等待时间
+    explicit WriteBehindQueue(std::shared_ptr<BackingStore<K, V>> backingStore,
+                              size_t maxPendingNum = 4096,
+                              size_t batch = 256,
+                              std::chrono::milliseconds interval = std::chrono::milliseconds(50))
+    : store(std::move(backingStore))
+    , maxPending(maxPendingNum > 0 ? maxPendingNum : 1)
+    , batchSize(batch > 0 ? batch : 1)
+    , flushInterval(interval)
+    , flushNow(false)
+    , writtenNum(0)
+    , batchNum(0)
+    , failedNum(0)
+    , stopping(false)
+    {
+        pendingIndex.reserve(maxPending);
+        flusher = std::thread([this] { run(); });
+    }
+
+    WriteBehindQueue(const WriteBehindQueue&) = delete;
+    WriteBehindQueue& operator=(const WriteBehindQueue&) = delete;
+
+    //停止前写回全部剩余数据
+    ~WriteBehindQueue()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mtx);
+            stopping = true;
+        }
+        wakeFlusher.notify_one();
+        flusher.join();
+    }
+
+    //放入一条待写回的数据，键已在队列中时覆盖旧值；从不阻塞，可以在持有缓存锁时调用，限流见throttle
+    template <typename KK, typename VV>
+    void enqueue(KK&& key, VV&& value)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = pendingIndex.find(key);
+        if(it != pendingIndex.end())
+        {
+            pendingValues[it->second] = std::forward<VV>(value);
+            return;
+        }
+        pendingIndex.emplace(key, pendingKeys.size());
+        pendingKeys.emplace_back(std::forward<KK>(key));
+        pendingValues.emplace_back(std::forward<VV>(value));
+        if(pendingKeys.size() >= batchSize)wakeFlusher.notify_one();
+    }
+
+    //限流：待写回的键达到上限时通知后台线程立即写回，并阻塞到它取走一批；不能在持有缓存锁时调用
+    void throttle()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        if(pendingKeys.size() < maxPending)return;
+        flushNow = true;
+        wakeFlusher.notify_one();
+        notFull.wait(lock, [this] { return pendingKeys.size() < maxPending || stopping; });
+    }
+
+    //查找尚未写回完成的数据，较新的待写回数据优先
+    bool find(const K& key, V& value)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto it = pendingIndex.find(key);
+        if(it != pendingIndex.end())
+        {
+            value = pendingValues[it->second];
+            return true;
+        }
+        it = flushingIndex.find(key);
+        if(it != flushingIndex.end())
+        {
+            value = flushingValues[it->second];
+            return true;
+        }
+        return false;
+    }
+
+    //立即写回，阻塞到调用前入队的数据全部写回
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        flushNow = true;
+        wakeFlusher.notify_one();
+        drained.wait(lock, [this] { return pendingKeys.empty() && flushingKeys.empty(); });
+    }
+
+    //待写回与正在写回的条数
+    size_t pending()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return pendingKeys.size() + flushingKeys.size();
+    }
+    //已写回的条数
+    size_t written()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return writtenNum;
+    }
+    //storeMany的调用次数
+    size_t batches()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return batchNum;
+    }
+    //写回失败而丢弃的条数
+    size_t failed()
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        return failedNum;
+    }
+};
+
+//缓存写路径使用的锁：构造时加缓存锁并取得当前的写回队列，析构时先释放缓存锁，再调用队列的throttle对写入方限流
+//淘汰与过期在缓存锁内入队从不阻塞，后台线程在storeMany中等待I/O时，其他分片与同一分片的读者不会被卡住
+template <typename K, typename V>
+class WriteBackLock
+{
+private:
+    std::unique_lock<std::mutex> lock;              //先于queue构造，取队列时已持有缓存锁
+    std::shared_ptr<WriteBehindQueue<K, V>> queue;
+
+public:
+    WriteBackLock(std::mutex& mtx, const std::shared_ptr<WriteBehindQueue<K, V>>& writeBack)
+    : lock(mtx)
+    , queue(writeBack) {}
+
+    WriteBackLock(const WriteBackLock&) = delete;
+    WriteBackLock& operator=(const WriteBackLock&) = delete;
+
+    ~WriteBackLock()
+    {
+        lock.unlock();
+        if(queue)queue->throttle();
+    }
+};
+
+}
+#endif //MYCACHE_WRITEBEHIND_H
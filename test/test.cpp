@@ -10,6 +10,7 @@
 #include "../include/LfuCache.h"
 #include "../include/LruCache.h"
 #include "../include/ArcCache.h"
+#include "../include/TinyLfuCache.h"
 
 class Timer {
 public:
@@ -35,6 +36,8 @@ void printResults(const std::string& testName, int capacity,
               << (100.0 * hits[1] / get_operations[1]) << "%" << std::endl;
     std::cout << "ARC - 命中率: " << std::fixed << std::setprecision(2) 
               << (100.0 * hits[2] / get_operations[2]) << "%" << std::endl;
+    std::cout << "W-TinyLFU - 命中率: " << std::fixed << std::setprecision(2) 
+              << (100.0 * hits[3] / get_operations[3]) << "%" << std::endl;
 }
 
 void testHotDataAccess() {
@@ -48,16 +51,17 @@ void testHotDataAccess() {
     mycache::LruCache<int, std::string> lru(CAPACITY);
     mycache::LfuCache<int, std::string> lfu(CAPACITY);
     mycache::ArcCache<int, std::string> arc(CAPACITY);
+    mycache::TinyLfuCache<int, std::string> tinyLfu(CAPACITY);
 
     std::random_device rd;
     std::mt19937 gen(rd());
     
-    mycache::CachePolicy<int, std::string>*caches[3] = {&lru, &lfu, &arc};
-    std::vector<int> hits(3, 0);
-    std::vector<int> get_operations(3, 0);
+    mycache::CachePolicy<int, std::string>*caches[4] = {&lru, &lfu, &arc, &tinyLfu};
+    std::vector<int> hits(4, 0);
+    std::vector<int> get_operations(4, 0);
 
     // 先进行一系列put操作
-    for (int i = 0; i < 3; ++i) {
+    for (int i = 0; i < 4; ++i) {
         for (int op = 0; op < OPERATIONS; ++op) {
             int key;
             if (op % 100 < 40) {  // 40%热点数据
@@ -99,16 +103,17 @@ void testLoopPattern() {
     mycache::LruCache<int, std::string> lru(CAPACITY);
     mycache::LfuCache<int, std::string> lfu(CAPACITY);
     mycache::ArcCache<int, std::string> arc(CAPACITY);
+    mycache::TinyLfuCache<int, std::string> tinyLfu(CAPACITY);
 
-    mycache::CachePolicy<int, std::string>* caches[3] = {&lru, &lfu, &arc};
-    std::vector<int> hits(3, 0);
-    std::vector<int> get_operations(3, 0);
+    mycache::CachePolicy<int, std::string>* caches[4] = {&lru, &lfu, &arc, &tinyLfu};
+    std::vector<int> hits(4, 0);
+    std::vector<int> get_operations(4, 0);
 
     std::random_device rd;
     std::mt19937 gen(rd());
 
     // 先填充数据
-    for (int i = 0; i < 3; ++i) {
+    for (int i = 0; i < 4; ++i) {
         for (int key = 0; key < LOOP_SIZE * 2; ++key) {
             std::string value = "loop" + std::to_string(key);
             caches[i]->put(key, value);
@@ -149,15 +154,16 @@ void testWorkloadShift() {
     mycache::LruKCache<int, std::string> lruk(CAPACITY,CAPACITY/2,2);
     mycache::LfuCache<int, std::string> lfu(CAPACITY);
     mycache::ArcCache<int, std::string> arc(CAPACITY);
+    mycache::TinyLfuCache<int, std::string> tinyLfu(CAPACITY);
 
     std::random_device rd;
     std::mt19937 gen(rd());
-    mycache::CachePolicy<int, std::string>*caches[3] = {&lru, &lfu, &arc};
-    std::vector<int> hits(3, 0);
-    std::vector<int> get_operations(3, 0);
+    mycache::CachePolicy<int, std::string>*caches[4] = {&lru, &lfu, &arc, &tinyLfu};
+    std::vector<int> hits(4, 0);
+    std::vector<int> get_operations(4, 0);
 
     // 先填充一些初始数据
-    for (int i = 0; i < 3; ++i) {
+    for (int i = 0; i < 4; ++i) {
         for (int key = 0; key < 1000; ++key) {
             std::string value = "init" + std::to_string(key);
             caches[i]->put(key, value);
@@ -10,6 +10,7 @@
 #include "../include/LfuCache.h"
 #include "../include/LruCache.h"
 #include "../include/ArcCache.h"
+#include "../include/ClassicArcCache.h"
 #include "../include/ClockCache.h"
 // 测试命中率的通用函数
 template <typename Cache>
@@ -95,5 +96,9 @@ int main() {
     mycache::ArcCache<int, int> arcCache(cacheCapacity);
     testHitRate(arcCache, testDataSize, "ARC Cache");
 
+    // 测试经典 ARC 缓存命中率
+    mycache::ClassicArcCache<int, int> classicArcCache(cacheCapacity);
+    testHitRate(classicArcCache, testDataSize, "Classic ARC Cache");
+
     return 0;
 }
\ No newline at end of file
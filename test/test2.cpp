@@ -10,6 +10,11 @@
 #include "../include/LfuCache.h"
 #include "../include/LruCache.h"
 #include "../include/ArcCache.h"
+#include "../include/ClassicArcCache.h"
+#include "../include/CarCache.h"
+#include "../include/TinyLfuCache.h"
+#include "../include/SieveCache.h"
+#include "../include/S3FifoCache.h"
 #include "../include/ClockCache.h"
 // 测试命中率的通用函数
 template <typename Cache>
@@ -71,5 +76,25 @@ int main() {
     mycache::ArcCache<int, int> arcCache(cacheCapacity);
     testHitRate(arcCache, testDataSize, "ARC Cache");
 
+    // 测试经典 ARC 缓存命中率
+    mycache::ClassicArcCache<int, int> classicArcCache(cacheCapacity);
+    testHitRate(classicArcCache, testDataSize, "Classic ARC Cache");
+
+    // 测试 CAR 缓存命中率
+    mycache::CarCache<int, int> carCache(cacheCapacity);
+    testHitRate(carCache, testDataSize, "CAR Cache");
+
+    // 测试 W-TinyLFU 缓存命中率
+    mycache::TinyLfuCache<int, int> tinyLfuCache(cacheCapacity);
+    testHitRate(tinyLfuCache, testDataSize, "W-TinyLFU Cache");
+
+    // 测试 SIEVE 缓存命中率
+    mycache::SieveCache<int, int> sieveCache(cacheCapacity);
+    testHitRate(sieveCache, testDataSize, "SIEVE Cache");
+
+    // 测试 S3-FIFO 缓存命中率
+    mycache::S3FifoCache<int, int> s3FifoCache(cacheCapacity);
+    testHitRate(s3FifoCache, testDataSize, "S3-FIFO Cache");
+
     return 0;
 }
\ No newline at end of file
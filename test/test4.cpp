@@ -4,12 +4,22 @@
 #include <vector>
 #include <chrono>
 #include <cassert>
+#include <atomic>
+#include <filesystem>
 #include <Windows.h>
 #include "../include/CachePolicy.h"
 #include "../include/LruCache.h"
 #include "../include/LfuCache.h"
 #include "../include/ArcCache.h"
+#include "../include/ClassicArcCache.h"
 #include "../include/ClockCache.h"
+#include "../include/ConcurrentClockCache.h"
+#include "../include/ConcurrentLruCache.h"
+#include "../include/SieveCache.h"
+#include "../include/S3FifoCache.h"
+#include "../include/BackingStore.h"
+#include "../include/WriteBehind.h"
+#include "../include/LoadingCache.h"
 // 并发测试的通用函数
 template <typename Cache>
 void testConcurrency(Cache& cache, size_t testDataSize, int numThreads, std::string cacheName) {
@@ -58,6 +68,338 @@ void testConcurrency(Cache& cache, size_t testDataSize, int numThreads, std::str
     std::cout << "----------------------------------------\n";
 }
 
+// 只读负载的扩展性测试：先写满缓存，各线程只读取已缓存的键，比较不同线程数下的QPS
+template <typename Cache>
+void testReadScaling(Cache& cache, size_t keyCount, size_t readsPerThread, std::string cacheName) {
+    for (size_t key = 0; key < keyCount; ++key) {
+        cache.put(static_cast<int>(key), static_cast<int>(key) + 1);
+    }
+    std::cout << "测试缓存：    " << cacheName << "（只读扩展性）" << std::endl;
+    for (int numThreads : {1, 2, 4, 8, 16}) {
+        std::atomic<size_t> misses(0);
+        auto task = [&](int seed) {
+            std::mt19937 gen(seed);
+            std::uniform_int_distribution<> dis(0, keyCount - 1);
+            for (size_t i = 0; i < readsPerThread; ++i) {
+                int value = 0;
+                if (!cache.get(dis(gen), value)) {
+                    misses.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        };
+        auto start = std::chrono::high_resolution_clock::now();
+        std::vector<std::thread> threads;
+        for (int i = 0; i < numThreads; ++i) {
+            threads.emplace_back(task, i);
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        auto end = std::chrono::high_resolution_clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        double qps = static_cast<double>(readsPerThread * numThreads) / (duration / 1000000.0);
+        std::cout << "线程数 " << numThreads << "：QPS " << qps << "，未命中 " << misses.load() << std::endl;
+    }
+    std::cout << "----------------------------------------\n";
+}
+
+// 读-改-写接口的并发测试：与testConcurrency的读写逻辑相同，但由merge在一次加锁内完成
+template <typename Cache>
+void testComputeConcurrency(Cache& cache, size_t testDataSize, int numThreads, std::string cacheName) {
+    auto task = [&](Cache& cache, int seed) {
+        std::mt19937 gen(seed);
+        std::uniform_int_distribution<> dis(0, testDataSize - 1);
+        for (size_t i = 0; i < testDataSize; ++i) {
+            int key = dis(gen);
+            // 如果存在，值加1；如果不存在，添加新值
+            cache.merge(key, key + 1, [](const int& old, const int&) { return old + 1; });
+        }
+    };
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(task, std::ref(cache), i);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    double totalRequests = static_cast<double>(testDataSize * numThreads);
+    double qps = totalRequests / (duration / 1000.0);
+
+    std::cout << "测试缓存：    " << cacheName << "（merge）" << std::endl;
+    std::cout << "线程数：      " << numThreads << std::endl;
+    std::cout << "测试用时：    " << duration << "ms" << std::endl;
+    std::cout << "总请求数：    " << totalRequests << std::endl;
+    std::cout << "QPS：" << qps << " queries/second" << std::endl;
+    std::cout << "----------------------------------------\n";
+}
+
+// 批量接口的并发测试：每个请求批量读取batchSize个键，未命中的键再批量写入
+template <typename Cache>
+void testBatchConcurrency(Cache& cache, size_t testDataSize, int numThreads, size_t batchSize, std::string cacheName) {
+    auto task = [&](Cache& cache, int seed) {
+        std::mt19937 gen(seed);
+        std::uniform_int_distribution<> dis(0, testDataSize - 1);
+        std::vector<int> keys(batchSize), values(batchSize), missKeys, missValues;
+        std::vector<uint64_t> hitBits((batchSize + 63) / 64);
+        for (size_t i = 0; i < testDataSize; i += batchSize) {
+            for (size_t j = 0; j < batchSize; ++j) {
+                keys[j] = dis(gen);
+            }
+            cache.getMany(keys.data(), batchSize, values.data(), hitBits.data());
+            missKeys.clear();
+            missValues.clear();
+            for (size_t j = 0; j < batchSize; ++j) {
+                if (!(hitBits[j / 64] >> (j % 64) & 1)) {
+                    missKeys.push_back(keys[j]);
+                    missValues.push_back(keys[j] + 1);
+                }
+            }
+            cache.putMany(missKeys.data(), missValues.data(), missKeys.size());
+        }
+    };
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(task, std::ref(cache), i);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    double totalRequests = static_cast<double>(testDataSize * numThreads);
+    double qps = totalRequests / (duration / 1000.0);
+
+    std::cout << "测试缓存：    " << cacheName << "（批量 " << batchSize << "）" << std::endl;
+    std::cout << "线程数：      " << numThreads << std::endl;
+    std::cout << "测试用时：    " << duration << "ms" << std::endl;
+    std::cout << "总请求数：    " << totalRequests << std::endl;
+    std::cout << "QPS：" << qps << " queries/second" << std::endl;
+    std::cout << "----------------------------------------\n";
+}
+
+template <typename Cache>
+void testLoadConcurrency(Cache& cache, size_t testDataSize, int numThreads, std::string cacheName) {
+    std::atomic<size_t> loads(0);
+    //模拟较慢的后端加载，同一个键的并发未命中只应加载一次
+    auto loader = [&loads](const int& key) {
+        loads.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        return key + 1;
+    };
+    auto task = [&](Cache& cache, int seed) {
+        std::mt19937 gen(seed);
+        std::uniform_int_distribution<> dis(0, testDataSize - 1);
+        for (size_t i = 0; i < testDataSize; ++i) {
+            int key = dis(gen);
+            int value = cache.getOrLoad(key, loader);
+            assert(value == key + 1);
+            (void)value;
+        }
+    };
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(task, std::ref(cache), i);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    double totalRequests = static_cast<double>(testDataSize * numThreads);
+
+    std::cout << "测试缓存：    " << cacheName << "（getOrLoad）" << std::endl;
+    std::cout << "线程数：      " << numThreads << std::endl;
+    std::cout << "测试用时：    " << duration << "ms" << std::endl;
+    std::cout << "总请求数：    " << totalRequests << std::endl;
+    std::cout << "加载次数：    " << loads.load() << std::endl;
+    std::cout << "----------------------------------------\n";
+}
+// 模拟较慢的存储：每次批量写入额外耗时1ms
+class SlowFileStore : public mycache::FileBackingStore<int, int> {
+public:
+    using mycache::FileBackingStore<int, int>::FileBackingStore;
+    void storeMany(const int* keys, const int* values, size_t n) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        mycache::FileBackingStore<int, int>::storeMany(keys, values, n);
+    }
+};
+
+template <typename Cache>
+void testWriteBehindConcurrency(Cache& cache, size_t testDataSize, int numThreads, int rounds, std::string cacheName) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "mycache_write_behind";
+    std::filesystem::remove_all(dir);
+    auto store = std::make_shared<SlowFileStore>(dir.string());
+    auto queue = std::make_shared<mycache::WriteBehindQueue<int, int>>(store, 1024, 64);
+    cache.setWriteBack(queue);
+
+    // 每个线程只写自己的键，每轮写入轮次号，全部结束后存储中应为最后一轮的值
+    auto task = [&](int id) {
+        for (int round = 1; round <= rounds; ++round) {
+            for (size_t key = id; key < testDataSize; key += numThreads) {
+                cache.put(static_cast<int>(key), round);
+            }
+        }
+    };
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(task, i);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    cache.flush();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    size_t mismatches = 0;
+    for (size_t key = 0; key < testDataSize; ++key) {
+        int value = 0;
+        if (!store->load(static_cast<int>(key), value) || value != rounds) {
+            ++mismatches;
+        }
+    }
+
+    std::cout << "测试缓存：    " << cacheName << "（异步写回）" << std::endl;
+    std::cout << "线程数：      " << numThreads << std::endl;
+    std::cout << "写入用时：    " << duration << "ms" << std::endl;
+    std::cout << "总写入数：    " << testDataSize * rounds << std::endl;
+    std::cout << "写回条数：    " << queue->written() << "，批次 " << queue->batches() << std::endl;
+    std::cout << "存储不一致：  " << mismatches << std::endl;
+    std::cout << "----------------------------------------\n";
+
+    cache.setWriteBack(nullptr);
+    std::filesystem::remove_all(dir);
+}
+
+template <typename Cache>
+void testReadThroughConcurrency(Cache& cache, size_t testDataSize, int numThreads, std::string cacheName) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "mycache_read_through";
+    std::filesystem::remove_all(dir);
+    auto store = std::make_shared<mycache::FileBackingStore<int, int>>(dir.string());
+    for (size_t key = 0; key < testDataSize; ++key) {
+        store->store(static_cast<int>(key), static_cast<int>(key) * 2);
+    }
+    mycache::LoadingCache<int, int> loading(cache, store, 4);
+
+    // 预取前一半的键，读取时应全部命中缓存
+    std::vector<int> warm;
+    for (size_t key = 0; key < testDataSize / 2; ++key) {
+        warm.push_back(static_cast<int>(key));
+    }
+    loading.prefetch(warm);
+    loading.waitIdle();
+
+    // 读穿透与写穿透混合，写入的值与存储中的相同，任何时刻读到的都应是key * 2
+    std::atomic<size_t> mismatches(0);
+    auto task = [&](int seed) {
+        std::mt19937 gen(seed);
+        std::uniform_int_distribution<> dis(0, testDataSize - 1);
+        for (size_t i = 0; i < testDataSize; ++i) {
+            int key = dis(gen);
+            if (i % 10 == 0) {
+                loading.put(key, key * 2);
+                continue;
+            }
+            int value = 0;
+            if (!loading.get(key, value) || value != key * 2) {
+                mismatches.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    };
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(task, i);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    std::cout << "测试缓存：    " << cacheName << "（读穿透与预取）" << std::endl;
+    std::cout << "线程数：      " << numThreads << std::endl;
+    std::cout << "测试用时：    " << duration << "ms" << std::endl;
+    std::cout << "总请求数：    " << testDataSize * numThreads << std::endl;
+    std::cout << "预取条数：    " << loading.prefetched() << std::endl;
+    std::cout << "存储加载：    " << loading.loads() << std::endl;
+    std::cout << "读取不一致：  " << mismatches.load() << std::endl;
+    std::cout << "----------------------------------------\n";
+
+    std::filesystem::remove_all(dir);
+}
+
+template <typename Cache>
+void testWriteThroughConcurrency(Cache& cache, size_t keyCount, int numThreads, int rounds, std::string cacheName) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "mycache_write_through";
+    std::filesystem::remove_all(dir);
+    auto store = std::make_shared<mycache::FileBackingStore<int, int>>(dir.string());
+    mycache::LoadingCache<int, int> loading(cache, store, 1);
+
+    // 所有线程反复写同一批键，单个写入与批量写入交替，结束后缓存中的值应与存储中的相同
+    auto task = [&](int id) {
+        std::vector<int> keys(keyCount);
+        std::vector<int> values(keyCount);
+        for (int round = 0; round < rounds; ++round) {
+            int value = id * rounds + round;
+            if (round % 2 == 0) {
+                for (size_t key = 0; key < keyCount; ++key) {
+                    loading.put(static_cast<int>(key), value);
+                }
+                continue;
+            }
+            for (size_t key = 0; key < keyCount; ++key) {
+                keys[key] = static_cast<int>(key);
+                values[key] = value;
+            }
+            loading.putMany(keys.data(), values.data(), keyCount);
+        }
+    };
+
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < numThreads; ++i) {
+        threads.emplace_back(task, i);
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+
+    size_t mismatches = 0;
+    for (size_t key = 0; key < keyCount; ++key) {
+        int cached = 0;
+        int stored = 0;
+        if (cache.get(static_cast<int>(key), cached) && (!store->load(static_cast<int>(key), stored) || cached != stored)) {
+            ++mismatches;
+        }
+    }
+
+    std::cout << "测试缓存：    " << cacheName << "（写穿透）" << std::endl;
+    std::cout << "线程数：      " << numThreads << std::endl;
+    std::cout << "写入用时：    " << duration << "ms" << std::endl;
+    std::cout << "总写入数：    " << keyCount * rounds * numThreads << std::endl;
+    std::cout << "缓存与存储不一致：" << mismatches << std::endl;
+    std::cout << "----------------------------------------\n";
+
+    std::filesystem::remove_all(dir);
+}
+
 int main() {
     size_t cacheCapacity = 100;
     size_t testDataSize = 400;
@@ -75,9 +417,38 @@ int main() {
     mycache::ClockCache<int, int> clockCache(cacheCapacity);
     testConcurrency(clockCache, testDataSize, numThreads, "Clock Cache");
 
+    // 测试读路径无锁的 Clock 缓存的并发性
+    mycache::ConcurrentClockCache<int, int> concurrentClockCache(cacheCapacity);
+    testConcurrency(concurrentClockCache, testDataSize, numThreads, "Concurrent Clock Cache");
+
+    // 测试读路径无锁、延迟调整顺序的 LRU 缓存的并发性
+    mycache::ConcurrentLruCache<int, int> concurrentLruCache(cacheCapacity);
+    testConcurrency(concurrentLruCache, testDataSize, numThreads, "Concurrent LRU Cache");
+
+    // 测试命中无锁的 SIEVE 与 S3-FIFO 缓存的并发性
+    mycache::HashSieveCache<int, int> hashSieveCache(cacheCapacity, 5);
+    testConcurrency(hashSieveCache, testDataSize, numThreads, "Hash SIEVE Cache");
+
+    mycache::HashS3FifoCache<int, int> hashS3FifoCache(cacheCapacity, 5);
+    testConcurrency(hashS3FifoCache, testDataSize, numThreads, "Hash S3-FIFO Cache");
+
+    // 测试只读负载下的扩展性：命中需要加锁调整链表的分片 LRU 与命中只写读缓冲的 LRU
+    mycache::HashLruCache<int, int> scalingHashLruCache(2048, 8);
+    testReadScaling(scalingHashLruCache, 1024, 200000, "Hash LRU Cache");
+
+    mycache::ConcurrentLruCache<int, int> scalingConcurrentLruCache(1024);
+    testReadScaling(scalingConcurrentLruCache, 1024, 200000, "Concurrent LRU Cache");
+
+    mycache::S3FifoCache<int, int> scalingS3FifoCache(1024);
+    testReadScaling(scalingS3FifoCache, 1024, 200000, "S3-FIFO Cache");
+
     // 测试 ARC 缓存的并发性
     mycache::ArcCache<int, int> arcCache(cacheCapacity);
     testConcurrency(arcCache, testDataSize, numThreads, "ARC Cache");
+
+    // 测试经典 ARC 缓存的并发性
+    mycache::ClassicArcCache<int, int> classicArcCache(cacheCapacity);
+    testConcurrency(classicArcCache, testDataSize, numThreads, "Classic ARC Cache");
     
     // 测试分片 LRU 缓存的并发性
     mycache::HashLruCache<int, int> hashLruCache(cacheCapacity, 5);
@@ -87,5 +458,60 @@ int main() {
     mycache::HashLfuCache<int, int> hashLfuCache(cacheCapacity, 5);
     testConcurrency(hashLfuCache, testDataSize, numThreads, "Hash LFU Cache");
 
+    // 测试分片 ARC 缓存的并发性
+    mycache::HashArcCache<int, int> hashArcCache(cacheCapacity, 5);
+    testConcurrency(hashArcCache, testDataSize, numThreads, "Hash ARC Cache");
+
+    // 测试分片 Clock 缓存的并发性
+    mycache::HashClockCache<int, int> hashClockCache(cacheCapacity, 5);
+    testConcurrency(hashClockCache, testDataSize, numThreads, "Hash Clock Cache");
+
+    // 测试分片缓存批量接口的并发性
+    mycache::HashLruCache<int, int> batchLruCache(cacheCapacity, 5);
+    testBatchConcurrency(batchLruCache, testDataSize, numThreads, 100, "Hash LRU Cache");
+
+    mycache::HashLfuCache<int, int> batchLfuCache(cacheCapacity, 5);
+    testBatchConcurrency(batchLfuCache, testDataSize, numThreads, 100, "Hash LFU Cache");
+
+    // 测试读-改-写接口的并发性
+    mycache::LruCache<int, int> computeLruCache(cacheCapacity);
+    testComputeConcurrency(computeLruCache, testDataSize, numThreads, "LRU Cache");
+
+    mycache::ArcCache<int, int> computeArcCache(cacheCapacity);
+    testComputeConcurrency(computeArcCache, testDataSize, numThreads, "ARC Cache");
+
+    mycache::HashLfuCache<int, int> computeLfuCache(cacheCapacity, 5);
+    testComputeConcurrency(computeLfuCache, testDataSize, numThreads, "Hash LFU Cache");
+
+    // 测试未命中合并加载的并发性
+    mycache::LruCache<int, int> loadLruCache(cacheCapacity);
+    testLoadConcurrency(loadLruCache, testDataSize, numThreads, "LRU Cache");
+
+    mycache::HashLruCache<int, int> loadHashLruCache(cacheCapacity, 5);
+    testLoadConcurrency(loadHashLruCache, testDataSize, numThreads, "Hash LRU Cache");
+
+    // 测试脏数据异步写回
+    mycache::HashLruCache<int, int> writeBackLruCache(cacheCapacity, 5);
+    testWriteBehindConcurrency(writeBackLruCache, testDataSize, numThreads, 20, "Hash LRU Cache");
+
+    mycache::HashClockCache<int, int> writeBackClockCache(cacheCapacity, 5);
+    testWriteBehindConcurrency(writeBackClockCache, testDataSize, numThreads, 20, "Hash Clock Cache");
+
+    mycache::ClassicArcCache<int, int> writeBackArcCache(cacheCapacity);
+    testWriteBehindConcurrency(writeBackArcCache, testDataSize, numThreads, 20, "Classic ARC Cache");
+
+    mycache::HashLfuCache<int, int> writeBackLfuCache(cacheCapacity, 5);
+    testWriteBehindConcurrency(writeBackLfuCache, testDataSize, numThreads, 20, "Hash LFU Cache");
+
+    // 测试读穿透、写穿透与异步预取
+    mycache::HashLruCache<int, int> readThroughLruCache(cacheCapacity * 2, 5);
+    testReadThroughConcurrency(readThroughLruCache, testDataSize, numThreads, "Hash LRU Cache");
+
+    mycache::ClassicArcCache<int, int> readThroughArcCache(cacheCapacity * 2);
+    testReadThroughConcurrency(readThroughArcCache, testDataSize, numThreads, "Classic ARC Cache");
+
+    mycache::HashLruCache<int, int> writeThroughLruCache(cacheCapacity, 5);
+    testWriteThroughConcurrency(writeThroughLruCache, 50, 8, 20, "Hash LRU Cache");
+
     return 0;
 }
\ No newline at end of file
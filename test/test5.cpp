@@ -0,0 +1,332 @@
+/* 内存分配次数测试，统计缓存写满进入稳态后的堆分配次数*/
+
+#include <random>
+#include <iostream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <chrono>
+#include <algorithm>
+#include <thread>
+#include <cassert>
+#include "../include/CachePolicy.h"
+#include "../include/LruCache.h"
+#include "../include/LfuCache.h"
+#include "../include/ArcCache.h"
+#include "../include/ClassicArcCache.h"
+#include "../include/ClockCache.h"
+
+// 全局分配计数，替换全局operator new/delete进行统计
+static std::atomic<size_t> allocCount(0);
+
+// 所有替换的operator new/delete都经过这两个不内联的函数，GCC看不到operator new返回的指针被直接free，
+// 不会报-Wmismatched-new-delete
+#if defined(_MSC_VER)
+#define TEST_NOINLINE __declspec(noinline)
+#else
+#define TEST_NOINLINE __attribute__((noinline))
+#endif
+
+TEST_NOINLINE static void* countedAlloc(size_t size)
+{
+    allocCount.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+TEST_NOINLINE static void countedFree(void* p) noexcept
+{
+    std::free(p);
+}
+
+void* operator new(size_t size)
+{
+    return countedAlloc(size);
+}
+void* operator new[](size_t size)
+{
+    return countedAlloc(size);
+}
+void operator delete(void* p) noexcept
+{
+    countedFree(p);
+}
+void operator delete[](void* p) noexcept
+{
+    countedFree(p);
+}
+void operator delete(void* p, size_t) noexcept
+{
+    countedFree(p);
+}
+void operator delete[](void* p, size_t) noexcept
+{
+    countedFree(p);
+}
+
+// 统计分配次数的通用函数
+template <typename Cache>
+void testAllocation(Cache& cache, size_t capacity, size_t testDataSize, std::string cacheName) {
+    std::mt19937 gen(12345);
+    std::uniform_int_distribution<int> dis(0, static_cast<int>(capacity * 4));
+
+    // 先写满缓存并进行一轮预热，使缓存进入稳态
+    for (size_t i = 0; i < capacity * 4; ++i) {
+        cache.put(static_cast<int>(i), static_cast<int>(i));
+    }
+    for (size_t i = 0; i < testDataSize; ++i) {
+        int key = dis(gen);
+        int value;
+        if (!cache.get(key, value)) {
+            cache.put(key, key + 1);
+        }
+    }
+
+    // 稳态下统计分配次数
+    size_t before = allocCount.load();
+    size_t hit = 0;
+    for (size_t i = 0; i < testDataSize; ++i) {
+        int key = dis(gen);
+        int value;
+        if (cache.get(key, value)) {
+            hit++;
+        } else {
+            cache.put(key, key + 1);
+        }
+    }
+    size_t allocs = allocCount.load() - before;
+
+    std::cout << "测试缓存：    " << cacheName << std::endl;
+    std::cout << "操作次数：    " << testDataSize << std::endl;
+    std::cout << "命中次数：    " << hit << std::endl;
+    std::cout << "堆分配次数：  " << allocs << std::endl;
+    std::cout << "----------------------------------------\n";
+}
+
+// 大值读取测试：对比get拷贝值与visit原地访问的分配次数与用时
+template <typename Cache>
+void testLargeValueRead(Cache& cache, size_t capacity, size_t testDataSize, size_t valueSize, std::string cacheName) {
+    for (size_t i = 0; i < capacity; ++i) {
+        cache.put(static_cast<int>(i), std::string(valueSize, static_cast<char>('a' + i % 26)));
+    }
+    std::mt19937 gen(12345);
+    std::uniform_int_distribution<int> dis(0, static_cast<int>(capacity - 1));
+    size_t checksum = 0;
+
+    size_t before = allocCount.load();
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < testDataSize; ++i) {
+        std::string value;
+        if (cache.get(dis(gen), value)) {
+            checksum += value.size();
+        }
+    }
+    auto mid = std::chrono::high_resolution_clock::now();
+    size_t getAllocs = allocCount.load() - before;
+
+    before = allocCount.load();
+    for (size_t i = 0; i < testDataSize; ++i) {
+        cache.visit(dis(gen), [&](const std::string& value) { checksum += value.size(); });
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    size_t visitAllocs = allocCount.load() - before;
+
+    std::cout << "测试缓存：    " << cacheName << "（值大小 " << valueSize << " 字节）" << std::endl;
+    std::cout << "get 堆分配：  " << getAllocs << "，用时 "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(mid - start).count() << "ms" << std::endl;
+    std::cout << "visit 堆分配：" << visitAllocs << "，用时 "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end - mid).count() << "ms" << std::endl;
+    std::cout << "校验和：      " << checksum << std::endl;
+    std::cout << "----------------------------------------\n";
+}
+
+// 按字节预算限制容量：值的大小从几十字节到几百KB不等，条目数上限放宽，由权重上限决定淘汰
+template <typename Cache>
+void testWeightBudget(Cache& cache, size_t maxWeight, size_t keyRange, size_t testDataSize, std::string cacheName) {
+    cache.setMaxWeight(maxWeight);
+    std::mt19937 gen(2024);
+    std::uniform_int_distribution<int> keyDis(0, static_cast<int>(keyRange - 1));
+    size_t hits = 0;
+    size_t peakWeight = 0;
+    for (size_t i = 0; i < testDataSize; ++i) {
+        int key = keyDis(gen);
+        std::string value;
+        if (cache.get(key, value)) {
+            ++hits;
+        } else {
+            // 每个键的值大小固定：大部分几十到几百字节，少数达到几百KB
+            size_t size = (key % 50 == 0) ? 256 * 1024 : 40 + static_cast<size_t>(key % 23) * 40;
+            cache.put(key, std::string(size, 'v'));
+        }
+        if (i % 1000 == 0) {
+            peakWeight = std::max(peakWeight, cache.totalWeight());
+        }
+    }
+
+    std::cout << "测试缓存：    " << cacheName << "（权重上限 " << maxWeight / 1024 << "KB）" << std::endl;
+    std::cout << "当前总权重：  " << cache.totalWeight() / 1024 << "KB，采样峰值 " << peakWeight / 1024 << "KB" << std::endl;
+    std::cout << "命中率：      " << 100.0 * hits / testDataSize << "%" << std::endl;
+    std::cout << "----------------------------------------\n";
+}
+
+// 过期测试：一半数据带短存活时间，到期后由时间轮删除并腾出容量；另测按访问续期的数据在持续访问时不会过期
+template <typename Cache>
+void testExpiry(Cache& cache, size_t capacity, std::string cacheName) {
+    using namespace std::chrono;
+    for (size_t i = 0; i < capacity; ++i) {
+        int key = static_cast<int>(i);
+        if (i % 2 == 0) {
+            cache.put(key, key, milliseconds(50));
+        } else {
+            cache.put(key, key);
+        }
+    }
+    std::this_thread::sleep_for(milliseconds(80));
+    size_t expired = cache.cleanUp();
+    size_t alive = 0;
+    for (size_t i = 0; i < capacity; ++i) {
+        int value;
+        if (cache.get(static_cast<int>(i), value)) {
+            ++alive;
+        }
+    }
+
+    // 按访问过期：键0每20ms访问一次，键1不再访问
+    cache.setExpiry(mycache::ExpireMode::AfterAccess, milliseconds(60));
+    cache.put(0, 0);
+    cache.put(1, 1);
+    int value;
+    for (int i = 0; i < 10; ++i) {
+        std::this_thread::sleep_for(milliseconds(20));
+        cache.get(0, value);
+    }
+    bool touchedAlive = cache.get(0, value);
+    bool idleAlive = cache.get(1, value);
+    cache.setExpiry(mycache::ExpireMode::AfterWrite, milliseconds(0));
+
+    std::cout << "测试缓存：    " << cacheName << std::endl;
+    std::cout << "到期删除：    " << expired << "，剩余 " << alive << " / " << capacity << std::endl;
+    std::cout << "按访问续期：  持续访问的键" << (touchedAlive ? "仍在" : "已过期")
+              << "，空闲的键" << (idleAlive ? "仍在" : "已过期") << std::endl;
+    std::cout << "----------------------------------------\n";
+}
+
+// 失效测试：每轮写入一批数据后按键集合批量删除其中一半，统计分配次数，并检查被删除的键不再命中、其余键的值不受影响
+template <typename Cache>
+void testInvalidation(Cache& cache, size_t capacity, size_t rounds, std::string cacheName) {
+    std::mt19937 gen(2024);
+    std::uniform_int_distribution<int> dis(0, static_cast<int>(capacity * 2));
+    std::vector<int> batch(capacity / 4), invalid(capacity / 8);
+    for (size_t i = 0; i < capacity * 2; ++i) {
+        cache.put(static_cast<int>(i), static_cast<int>(i));
+    }
+    // 先做一次批量失效，分片缓存按线程复用的分组缓冲在这里扩容，之后的轮次不应再分配内存
+    cache.removeMany(invalid.data(), invalid.size());
+
+    size_t before = allocCount.load();
+    size_t removed = 0;
+    size_t errors = 0;
+    for (size_t r = 0; r < rounds; ++r) {
+        for (size_t i = 0; i < batch.size(); ++i) {
+            batch[i] = dis(gen);
+            cache.put(batch[i], batch[i] * 2);
+        }
+        for (size_t i = 0; i < invalid.size(); ++i) {
+            invalid[i] = batch[i * 2];
+        }
+        removed += cache.removeMany(invalid.data(), invalid.size());
+        int value;
+        for (int key : invalid) {
+            if (cache.get(key, value)) ++errors;
+        }
+        for (size_t i = 1; i < batch.size(); i += 2) {
+            if (cache.get(batch[i], value) && value != batch[i] * 2 &&
+                std::find(invalid.begin(), invalid.end(), batch[i]) == invalid.end()) ++errors;
+        }
+    }
+    size_t allocations = allocCount.load() - before;
+
+    std::cout << "测试缓存：    " << cacheName << std::endl;
+    std::cout << "批量失效：    " << removed << " 条，" << rounds << " 轮" << std::endl;
+    std::cout << "错误结果：    " << errors << std::endl;
+    std::cout << "堆分配次数：  " << allocations << std::endl;
+    std::cout << "----------------------------------------\n";
+    assert(errors == 0);
+    assert(allocations == 0);
+}
+
+int main() {
+    size_t cacheCapacity = 1000;
+    size_t testDataSize = 200000;
+
+    // 测试 LRU 缓存的分配次数
+    mycache::LruCache<int, int> lruCache(cacheCapacity);
+    testAllocation(lruCache, cacheCapacity, testDataSize, "LRU Cache");
+
+    // 测试 LFU 缓存的分配次数
+    mycache::LfuCache<int, int> lfuCache(cacheCapacity);
+    testAllocation(lfuCache, cacheCapacity, testDataSize, "LFU Cache");
+
+    // 测试 Clock 缓存的分配次数
+    mycache::ClockCache<int, int> clockCache(cacheCapacity);
+    testAllocation(clockCache, cacheCapacity, testDataSize, "Clock Cache");
+
+    // 测试 ARC 缓存的分配次数
+    mycache::ArcCache<int, int> arcCache(cacheCapacity);
+    testAllocation(arcCache, cacheCapacity, testDataSize, "ARC Cache");
+
+    // 测试经典 ARC 缓存的分配次数
+    mycache::ClassicArcCache<int, int> classicArcCache(cacheCapacity);
+    testAllocation(classicArcCache, cacheCapacity, testDataSize, "Classic ARC Cache");
+
+    // 测试分片 LRU 缓存的分配次数
+    mycache::HashLruCache<int, int> hashLruCache(cacheCapacity, 4);
+    testAllocation(hashLruCache, cacheCapacity, testDataSize, "Hash LRU Cache");
+
+    // 测试分片 LFU 缓存的分配次数
+    mycache::HashLfuCache<int, int> hashLfuCache(cacheCapacity, 4);
+    testAllocation(hashLfuCache, cacheCapacity, testDataSize, "Hash LFU Cache");
+
+    // 测试大值读取时 get 与 visit 的差异
+    mycache::LruCache<int, std::string> lruStringCache(cacheCapacity);
+    testLargeValueRead(lruStringCache, cacheCapacity, testDataSize, 4096, "LRU Cache");
+
+    mycache::HashLfuCache<int, std::string> hashLfuStringCache(cacheCapacity, 4);
+    testLargeValueRead(hashLfuStringCache, cacheCapacity, testDataSize, 4096, "Hash LFU Cache");
+
+    // 测试按字节预算限制容量，条目数上限远大于预算能容纳的条目数
+    size_t maxWeight = 4 * 1024 * 1024;
+    size_t maxEntries = 100000;
+    mycache::LruCache<int, std::string> lruWeightCache(maxEntries);
+    testWeightBudget(lruWeightCache, maxWeight, 5000, testDataSize, "LRU Cache");
+
+    mycache::ClockCache<int, std::string> clockWeightCache(maxEntries);
+    testWeightBudget(clockWeightCache, maxWeight, 5000, testDataSize, "Clock Cache");
+
+    mycache::ClassicArcCache<int, std::string> classicArcWeightCache(maxEntries);
+    testWeightBudget(classicArcWeightCache, maxWeight, 5000, testDataSize, "Classic ARC Cache");
+
+    mycache::HashLfuCache<int, std::string> hashLfuWeightCache(maxEntries, 4);
+    testWeightBudget(hashLfuWeightCache, maxWeight, 5000, testDataSize, "Hash LFU Cache");
+
+    // 测试按存活时间过期
+    mycache::LruCache<int, int> lruExpiryCache(cacheCapacity);
+    testExpiry(lruExpiryCache, cacheCapacity, "LRU Cache");
+
+    mycache::ClockCache<int, int> clockExpiryCache(cacheCapacity);
+    testExpiry(clockExpiryCache, cacheCapacity, "Clock Cache");
+
+    mycache::HashLruCache<int, int> hashLruExpiryCache(cacheCapacity, 4);
+    testExpiry(hashLruExpiryCache, cacheCapacity, "Hash LRU Cache");
+
+    // 测试按键集合批量失效
+    mycache::ClockCache<int, int> clockInvalidCache(cacheCapacity);
+    testInvalidation(clockInvalidCache, cacheCapacity, 1000, "Clock Cache");
+
+    mycache::HashClockCache<int, int> hashClockInvalidCache(cacheCapacity, 4);
+    testInvalidation(hashClockInvalidCache, cacheCapacity, 1000, "Hash Clock Cache");
+
+    return 0;
+}